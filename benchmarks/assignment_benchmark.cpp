@@ -0,0 +1,240 @@
+//
+// assignment_benchmark.cpp: compares the linear assignment solvers on tracking-like problems
+//
+// Usage: assignment_benchmark [num_threads] [size ...]
+//
+// Each problem matches n tracks to 1.2 * n detections scattered over a square scene whose area grows with n,
+// so every track only overlaps a few detections. The cost is 1 - IoU, pairs above the threshold can't be assigned.
+// The reference is the Hungarian algorithm SORT used before the shared solvers: it assigns every track regardless
+// of the threshold, and the pairs above it are dropped afterwards.
+//
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Hungarian.hpp"
+#include "ThreadPool.h"
+#include "auction.h"
+#include "lapjv.h"
+#include "lsap.h"
+
+using namespace botsort;
+
+namespace
+{
+constexpr float cost_limit = 0.8f;
+constexpr float auction_epsilon = 1e-4f;
+constexpr int num_repeats = 3;
+
+struct Box
+{
+    float x, y, w, h;
+};
+
+float iou(const Box &a, const Box &b)
+{
+    const float w = std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x);
+    const float h = std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y);
+    if (w <= 0 || h <= 0)
+    {
+        return 0;
+    }
+    const float inter = w * h;
+    return inter / (a.w * a.h + b.w * b.h - inter);
+}
+
+// Row-major cost matrix of n_tracks x n_detections
+std::vector<float> make_problem(int n_tracks, int n_detections, std::mt19937 &rng)
+{
+    const float scene_size = 40.0f * std::sqrt(static_cast<float>(n_tracks));
+    std::uniform_real_distribution<float> position(0, scene_size);
+    std::uniform_real_distribution<float> size(10, 30);
+    std::normal_distribution<float> jitter(0, 3);
+
+    std::vector<Box> tracks(n_tracks), detections(n_detections);
+    for (Box &track: tracks)
+    {
+        track = {position(rng), position(rng), size(rng), size(rng)};
+    }
+    for (int j = 0; j < n_detections; j++)
+    {
+        if (j < n_tracks)
+        {
+            const Box &track = tracks[j];
+            detections[j] = {track.x + jitter(rng), track.y + jitter(rng), track.w, track.h};
+        }
+        else
+        {
+            detections[j] = {position(rng), position(rng), size(rng), size(rng)};
+        }
+    }
+    std::shuffle(detections.begin(), detections.end(), rng);
+
+    std::vector<float> cost(static_cast<size_t>(n_tracks) * n_detections);
+    for (int i = 0; i < n_tracks; i++)
+    {
+        for (int j = 0; j < n_detections; j++)
+        {
+            cost[static_cast<size_t>(i) * n_detections + j] = 1 - iou(tracks[i], detections[j]);
+        }
+    }
+    return cost;
+}
+
+// Square problem of size n_rows + n_cols with dummy rows and columns of cost cost_limit / 2,
+// as built by the previous lapjv wrapper
+std::vector<double> extend_problem(const std::vector<float> &cost, int n_rows, int n_cols)
+{
+    const size_t n = static_cast<size_t>(n_rows + n_cols);
+    std::vector<double> extended(n * n, cost_limit / 2.0);
+    for (size_t i = n_rows; i < n; i++)
+    {
+        std::fill_n(extended.begin() + i * n + n_cols, n_rows, 0.0);
+    }
+    for (int i = 0; i < n_rows; i++)
+    {
+        for (int j = 0; j < n_cols; j++)
+        {
+            extended[i * n + j] = cost[static_cast<size_t>(i) * n_cols + j];
+        }
+    }
+    return extended;
+}
+
+// Cost of the assignment, a track left unassigned or assigned above the threshold costs the threshold
+double total_cost(const std::vector<float> &cost, int n_cols, const std::vector<int_t> &x)
+{
+    double total = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        const bool assigned = x[i] >= 0 && x[i] < n_cols && cost[i * n_cols + x[i]] <= cost_limit;
+        total += assigned ? cost[i * n_cols + x[i]] : cost_limit;
+    }
+    return total;
+}
+
+// Cost matrix in the nested vectors taken by HungarianAlgorithm
+std::vector<std::vector<double>> to_nested(const std::vector<float> &cost, int n_rows, int n_cols)
+{
+    std::vector<std::vector<double>> nested(n_rows, std::vector<double>(n_cols));
+    for (int i = 0; i < n_rows; i++)
+    {
+        for (int j = 0; j < n_cols; j++)
+        {
+            nested[i][j] = cost[static_cast<size_t>(i) * n_cols + j];
+        }
+    }
+    return nested;
+}
+
+// Best time over the repeats, in milliseconds
+double time_ms(const std::function<void()> &solve)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int repeat = 0; repeat < num_repeats; repeat++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        solve();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+}// namespace
+
+int main(int argc, char **argv)
+{
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> sizes = {100, 500, 1000, 2000, 5000};
+    if (argc > 1)
+    {
+        num_threads = std::max(1, std::atoi(argv[1]));
+    }
+    if (argc > 2)
+    {
+        sizes.clear();
+        for (int arg = 2; arg < argc; arg++)
+        {
+            sizes.push_back(std::atoi(argv[arg]));
+        }
+    }
+
+    ThreadPool thread_pool(num_threads - 1);
+    std::mt19937 rng(42);
+
+    std::printf("%8s %8s %10s | %14s %14s %14s %14s %14s %14s\n", "tracks", "dets", "density",
+                "hungarian", "jv extended", "lsap dense", "lsap auto", "auction 1t",
+                (std::to_string(num_threads) + "t auction").c_str());
+    for (int n_tracks: sizes)
+    {
+        const int n_detections = n_tracks + n_tracks / 5;
+        const std::vector<float> cost = make_problem(n_tracks, n_detections, rng);
+        const size_t n_feasible = std::count_if(cost.begin(), cost.end(),
+                                                [](float c) { return c <= cost_limit; });
+        const double density = static_cast<double>(n_feasible) / cost.size();
+
+        std::vector<int_t> x(n_tracks), y(n_detections);
+        double reference = 0;
+
+        // The Hungarian algorithm is much slower, skip it on the largest problems
+        double hungarian_ms = -1, hungarian_cost = 0;
+        if (n_tracks <= 2000)
+        {
+            std::vector<std::vector<double>> nested = to_nested(cost, n_tracks, n_detections);
+            std::vector<int> assignment;
+            HungarianAlgorithm hungarian;
+            hungarian_ms = time_ms([&]() { hungarian.Solve(nested, assignment); });
+            hungarian_cost = total_cost(cost, n_detections, assignment);
+        }
+
+        // The extended matrix grows as (n_tracks + n_detections)^2, skip it once it gets too large
+        double jv_ms = -1;
+        if (n_tracks + n_detections <= 5000)
+        {
+            const std::vector<double> extended = extend_problem(cost, n_tracks, n_detections);
+            const uint_t n = n_tracks + n_detections;
+            std::vector<int_t> x_ext(n), y_ext(n);
+            LapjvBuffers<double> jv_buffers;
+            jv_ms = time_ms([&]() {
+                lapjv_internal<double>(n, extended.data(), x_ext.data(), y_ext.data(), jv_buffers);
+            });
+        }
+
+        LsapBuffers<float> lsap_buffers;
+        const double dense_ms = time_ms([&]() {
+            lsap_solve<float>(n_tracks, n_detections, cost.data(), cost_limit, x.data(), y.data(),
+                              lsap_buffers, 1.0f);
+        });
+        reference = total_cost(cost, n_detections, x);
+        const double auto_ms = time_ms([&]() {
+            lsap_solve<float>(n_tracks, n_detections, cost.data(), cost_limit, x.data(), y.data(),
+                              lsap_buffers);
+        });
+
+        AuctionBuffers<float> auction_buffers;
+        const double auction_ms = time_ms([&]() {
+            lsap_auction<float>(n_tracks, n_detections, cost.data(), cost_limit, x.data(), y.data(),
+                                auction_buffers, auction_epsilon);
+        });
+        const double parallel_auction_ms = time_ms([&]() {
+            lsap_auction<float>(n_tracks, n_detections, cost.data(), cost_limit, x.data(), y.data(),
+                                auction_buffers, auction_epsilon, &thread_pool);
+        });
+        const double auction_gap = total_cost(cost, n_detections, x) - reference;
+        const double hungarian_gap = hungarian_ms < 0 ? 0 : hungarian_cost - reference;
+
+        std::printf("%8d %8d %10.4f | %14.3f %14.3f %14.3f %14.3f %14.3f %14.3f"
+                    "   (cost gap: hungarian %.2e, auction %.2e)\n",
+                    n_tracks, n_detections, density, hungarian_ms, jv_ms, dense_ms, auto_ms, auction_ms,
+                    parallel_auction_ms, hungarian_gap, auction_gap);
+    }
+    return 0;
+}
@@ -25,7 +25,7 @@ public:
         {
             TrackedObject obj;
             obj.track_id = res->track_id;
-            const auto tlwh = res->get_tlwh();
+            const auto &tlwh = res->get_tlwh();
             obj.x = tlwh[0];
             obj.y = tlwh[1];
             obj.width = tlwh[2];
@@ -3,13 +3,49 @@
 #include "Sort.hpp" 
 #include "Detection.hpp"
 #include "TrackedObject.hpp"
+#include "INIReader.h"
+#include <iostream>
 
 class SortWrapper : public BaseTracker {
 private:
     Sort tracker;
     std::set<int> classes_to_track;
 public:
-    SortWrapper(const TrackConfig& config) : classes_to_track(config.classes_to_track) {}
+    SortWrapper(const TrackConfig& config)
+        : tracker(createSort(config.tracker_config_path)),
+          classes_to_track(config.classes_to_track)
+    {}
+
+    // Reads the [SORT] section of the tracker config, missing keys keep the Sort() defaults
+    static Sort createSort(const std::string& config_path)
+    {
+        INIReader tracker_config(config_path);
+        if (tracker_config.ParseError() < 0)
+            std::cout << "Info: Can't load " << config_path << ", using the default SORT parameters" << std::endl;
+
+        const std::string section = "SORT";
+        const std::string solver_name = tracker_config.Get(section, "assignment_solver", "lapjv");
+        botsort::AssignmentSolver solver = botsort::AssignmentSolver::LAPJV;
+        if (solver_name == "auction")
+            solver = botsort::AssignmentSolver::Auction;
+        else if (solver_name == "greedy")
+            solver = botsort::AssignmentSolver::Greedy;
+        else if (solver_name == "budgeted")
+            solver = botsort::AssignmentSolver::Budgeted;
+        else if (solver_name != "lapjv") {
+            std::cout << "Invalid assignment solver " << solver_name
+                      << ". Only 'lapjv', 'auction', 'greedy' and 'budgeted' are supported." << std::endl;
+            exit(1);
+        }
+
+        return Sort(static_cast<int>(tracker_config.GetInteger(section, "max_age", 5)),
+                    static_cast<int>(tracker_config.GetInteger(section, "min_hits", 3)),
+                    tracker_config.GetReal(section, "iou_threshold", 0.3),
+                    solver,
+                    tracker_config.GetFloat(section, "auction_epsilon", 1e-4f),
+                    tracker_config.GetFloat(section, "assignment_time_budget_us", 1000.0f),
+                    static_cast<int>(tracker_config.GetInteger(section, "kalman_steady_state_after", 0)));
+    }
 
     std::vector<TrackedObject> update(const std::vector<Detection>& detections, const cv::Mat& frame = cv::Mat()) override {
         // Convert Detection to ByteTrack's format if needed and use the update method
@@ -0,0 +1,464 @@
+//
+// assignment_test.cpp: checks the linear assignment solvers against brute-force enumeration
+//
+// Usage: assignment_test [num_trials]
+//
+// Every problem is small enough to enumerate all its partial matchings. The costs are small integers, so the
+// optimal total cost is exact in both float and double. Infeasible pairs are infinite. The auction solver is only
+// optimal within (n_rows + n_cols) * epsilon, which is below 1 with integer costs.
+//
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "auction.h"
+#include "lapjv.h"
+#include "lsap.h"
+
+using namespace botsort;
+
+namespace
+{
+constexpr int max_size = 6;
+constexpr double auction_epsilon = 1e-4;
+
+int num_failures = 0;
+
+void fail(const std::string &test, const std::string &message)
+{
+    if (num_failures < 20)
+    {
+        std::printf("FAILED %s: %s\n", test.c_str(), message.c_str());
+    }
+    num_failures++;
+}
+
+template<typename cost_t>
+struct Problem
+{
+    int n_rows, n_cols;
+    std::vector<cost_t> cost;// Row-major
+    cost_t unassigned_cost;
+};
+
+/**
+ * @brief Total cost of an assignment, as defined by lsap_internal: the assigned pairs, plus unassigned_cost / 2 for
+ *  every row and every column left unassigned. With an infinite unassigned_cost, columns are free to stay unassigned.
+ */
+template<typename cost_t>
+double total_cost(const Problem<cost_t> &problem, const std::vector<int_t> &x)
+{
+    double total = 0;
+    int num_assigned = 0;
+    for (int i = 0; i < problem.n_rows; i++)
+    {
+        if (x[i] >= 0)
+        {
+            total += problem.cost[static_cast<size_t>(i) * problem.n_cols + x[i]];
+            num_assigned++;
+        }
+    }
+
+    if (!std::isfinite(problem.unassigned_cost))
+    {
+        return num_assigned == problem.n_rows ? total : std::numeric_limits<double>::infinity();
+    }
+    return total + 0.5 * static_cast<double>(problem.unassigned_cost) *
+                           (problem.n_rows + problem.n_cols - 2 * num_assigned);
+}
+
+/**
+ * @brief Optimal total cost by enumerating every partial matching, infinite if no feasible assignment exists.
+ *  Rows may only be left unassigned with a finite unassigned_cost.
+ */
+template<typename cost_t>
+double brute_force_cost(const Problem<cost_t> &problem)
+{
+    const bool can_leave_unassigned = std::isfinite(problem.unassigned_cost);
+    std::vector<int_t> x(problem.n_rows, -1);
+    std::vector<bool> used(problem.n_cols, false);
+    double best = std::numeric_limits<double>::infinity();
+
+    std::function<void(int)> assign_row = [&](int i) {
+        if (i == problem.n_rows)
+        {
+            best = std::min(best, total_cost(problem, x));
+            return;
+        }
+        if (can_leave_unassigned)
+        {
+            x[i] = -1;
+            assign_row(i + 1);
+        }
+        for (int j = 0; j < problem.n_cols; j++)
+        {
+            if (!used[j] && std::isfinite(problem.cost[static_cast<size_t>(i) * problem.n_cols + j]))
+            {
+                used[j] = true;
+                x[i] = j;
+                assign_row(i + 1);
+                used[j] = false;
+            }
+        }
+        x[i] = -1;
+    };
+    assign_row(0);
+    return best;
+}
+
+/**
+ * @brief Random problem with integer costs in [0, 20], about one pair in four infeasible when with_infeasible is set.
+ *  With an infinite unassigned_cost, n_rows <= n_cols as required by the solvers.
+ */
+template<typename cost_t>
+Problem<cost_t> make_problem(std::mt19937 &rng, bool finite_unassigned_cost, bool with_infeasible)
+{
+    std::uniform_int_distribution<int> size(1, max_size);
+    std::uniform_int_distribution<int> value(0, 20);
+    std::bernoulli_distribution infeasible(with_infeasible ? 0.25 : 0.0);
+
+    Problem<cost_t> problem;
+    problem.n_rows = size(rng);
+    problem.n_cols = size(rng);
+    problem.unassigned_cost = finite_unassigned_cost ? static_cast<cost_t>(value(rng))
+                                                     : std::numeric_limits<cost_t>::infinity();
+    if (!finite_unassigned_cost && problem.n_rows > problem.n_cols)
+    {
+        std::swap(problem.n_rows, problem.n_cols);
+    }
+
+    problem.cost.resize(static_cast<size_t>(problem.n_rows) * problem.n_cols);
+    for (cost_t &c: problem.cost)
+    {
+        c = infeasible(rng) ? std::numeric_limits<cost_t>::infinity() : static_cast<cost_t>(value(rng));
+    }
+    return problem;
+}
+
+/**
+ * @brief Check a solver result against the brute-force optimum: the same feasibility, consistent x and y, only
+ *  finite pairs assigned, every row assigned with an infinite unassigned_cost, and the optimal total cost up to
+ *  tolerance
+ */
+template<typename cost_t>
+void check_solution(const std::string &test, const Problem<cost_t> &problem, int_t result,
+                    const std::vector<int_t> &x, const std::vector<int_t> &y, double tolerance = 1e-6)
+{
+    const double expected = brute_force_cost(problem);
+    const std::string size = std::to_string(problem.n_rows) + "x" + std::to_string(problem.n_cols) +
+                             ", unassigned_cost " + std::to_string(problem.unassigned_cost);
+    if (!std::isfinite(expected))
+    {
+        if (result != -1)
+        {
+            fail(test, size + ": infeasible problem not reported");
+        }
+        return;
+    }
+    if (result != 0)
+    {
+        fail(test, size + ": feasible problem reported infeasible");
+        return;
+    }
+
+    for (int i = 0; i < problem.n_rows; i++)
+    {
+        if (x[i] < -1 || x[i] >= problem.n_cols || (x[i] >= 0 && y[x[i]] != i))
+        {
+            fail(test, size + ": x and y are inconsistent");
+            return;
+        }
+        if (x[i] < 0 && !std::isfinite(problem.unassigned_cost))
+        {
+            fail(test, size + ": row left unassigned with an infinite unassigned_cost");
+            return;
+        }
+    }
+    for (int j = 0; j < problem.n_cols; j++)
+    {
+        if (y[j] < -1 || y[j] >= problem.n_rows || (y[j] >= 0 && x[y[j]] != j))
+        {
+            fail(test, size + ": x and y are inconsistent");
+            return;
+        }
+    }
+
+    const double actual = total_cost(problem, x);
+    if (!std::isfinite(actual) || std::abs(actual - expected) > tolerance)
+    {
+        fail(test, size + ": total cost " + std::to_string(actual) + ", optimum " + std::to_string(expected));
+    }
+}
+
+/**
+ * @brief Feasible edges of the problem in CSR format, for lsap_sparse_internal
+ */
+template<typename cost_t>
+void to_csr(const Problem<cost_t> &problem, std::vector<int_t> &row_offsets, std::vector<int_t> &col_indices,
+            std::vector<cost_t> &values)
+{
+    row_offsets.assign(1, 0);
+    col_indices.clear();
+    values.clear();
+    for (int i = 0; i < problem.n_rows; i++)
+    {
+        for (int j = 0; j < problem.n_cols; j++)
+        {
+            const cost_t c = problem.cost[static_cast<size_t>(i) * problem.n_cols + j];
+            if (std::isfinite(c))
+            {
+                col_indices.push_back(j);
+                values.push_back(c);
+            }
+        }
+        row_offsets.push_back(static_cast<int_t>(col_indices.size()));
+    }
+}
+
+template<typename cost_t>
+int_t solve_dense(const Problem<cost_t> &problem, std::vector<int_t> &x, std::vector<int_t> &y,
+                  LsapBuffers<cost_t> &buffers, const LsapWarmStart<cost_t> *warm_start = nullptr)
+{
+    x.assign(problem.n_rows, -2);
+    y.assign(problem.n_cols, -2);
+    return lsap_internal<cost_t>(problem.n_rows, problem.n_cols, problem.cost.data(), problem.unassigned_cost,
+                                 x.data(), y.data(), buffers, warm_start);
+}
+
+template<typename cost_t>
+int_t solve_sparse(const Problem<cost_t> &problem, std::vector<int_t> &x, std::vector<int_t> &y,
+                   LsapBuffers<cost_t> &buffers, const LsapWarmStart<cost_t> *warm_start = nullptr)
+{
+    std::vector<int_t> row_offsets, col_indices;
+    std::vector<cost_t> values;
+    to_csr(problem, row_offsets, col_indices, values);
+
+    x.assign(problem.n_rows, -2);
+    y.assign(problem.n_cols, -2);
+    return lsap_sparse_internal<cost_t>(problem.n_rows, problem.n_cols, row_offsets.data(), col_indices.data(),
+                                        values.data(), problem.unassigned_cost, x.data(), y.data(), buffers,
+                                        warm_start);
+}
+
+/**
+ * @brief Dense and sparse solvers, every row assigned (infinite unassigned_cost, n_rows <= n_cols)
+ */
+template<typename cost_t>
+void test_complete_assignment(std::mt19937 &rng, int num_trials)
+{
+    LsapBuffers<cost_t> dense_buffers, sparse_buffers;
+    std::vector<int_t> x, y;
+    for (int trial = 0; trial < num_trials; trial++)
+    {
+        const Problem<cost_t> problem = make_problem<cost_t>(rng, false, trial % 2 == 1);
+        check_solution("dense", problem, solve_dense(problem, x, y, dense_buffers), x, y);
+        check_solution("sparse", problem, solve_sparse(problem, x, y, sparse_buffers), x, y);
+    }
+}
+
+/**
+ * @brief Dense and sparse solvers with a finite unassigned_cost, on rectangular problems of either orientation:
+ *  the result must match the problem extended with dummy rows and columns of cost unassigned_cost / 2
+ */
+template<typename cost_t>
+void test_rectangular_with_dummies(std::mt19937 &rng, int num_trials)
+{
+    LsapBuffers<cost_t> dense_buffers, sparse_buffers;
+    std::vector<int_t> x, y;
+    for (int trial = 0; trial < num_trials; trial++)
+    {
+        const Problem<cost_t> problem = make_problem<cost_t>(rng, true, trial % 2 == 1);
+        check_solution("dense with dummies", problem, solve_dense(problem, x, y, dense_buffers), x, y);
+        check_solution("sparse with dummies", problem, solve_sparse(problem, x, y, sparse_buffers), x, y);
+    }
+}
+
+/**
+ * @brief Warm starts from the solution of another problem, from a perturbed solution and from random seeds and
+ *  prices: whatever the seed, the result must be optimal
+ */
+template<typename cost_t>
+void test_warm_start(std::mt19937 &rng, int num_trials)
+{
+    std::uniform_int_distribution<int> perturbation(-3, 3);
+    std::uniform_int_distribution<int> price(-20, 5);
+    std::bernoulli_distribution coin(0.5);
+
+    LsapBuffers<cost_t> buffers, warm_buffers;
+    std::vector<int_t> x, y;
+    for (int trial = 0; trial < num_trials; trial++)
+    {
+        Problem<cost_t> problem = make_problem<cost_t>(rng, coin(rng), coin(rng));
+        std::vector<int_t> seed_x(problem.n_rows, -1);
+        std::vector<cost_t> seed_v(problem.n_cols, 0);
+
+        switch (trial % 3)
+        {
+            case 0:
+            case 1:
+            {
+                // Solution and duals of the problem before its costs change, as between two frames
+                if (solve_dense(problem, x, y, buffers) == 0)
+                {
+                    seed_x = x;
+                    seed_v.assign(buffers.v.begin(), buffers.v.begin() + problem.n_cols);
+                }
+                for (cost_t &c: problem.cost)
+                {
+                    if (std::isfinite(c))
+                    {
+                        c = std::max(cost_t(0), c + static_cast<cost_t>(perturbation(rng)));
+                    }
+                }
+                if (trial % 3 == 1)
+                {
+                    // Some seeded rows also move to another column, possibly one seeded for another row
+                    std::uniform_int_distribution<int> column(-1, problem.n_cols - 1);
+                    for (int_t &j: seed_x)
+                    {
+                        if (coin(rng))
+                        {
+                            j = column(rng);
+                        }
+                    }
+                }
+                break;
+            }
+            default:
+            {
+                // Random seeds and prices, positive ones included
+                std::uniform_int_distribution<int> column(-1, problem.n_cols - 1);
+                for (int_t &j: seed_x)
+                {
+                    j = column(rng);
+                }
+                for (cost_t &v: seed_v)
+                {
+                    v = static_cast<cost_t>(price(rng));
+                }
+                break;
+            }
+        }
+
+        const LsapWarmStart<cost_t> warm_start{seed_x.data(), seed_v.data()};
+        check_solution("dense warm start", problem, solve_dense(problem, x, y, warm_buffers, &warm_start), x, y);
+        check_solution("sparse warm start", problem, solve_sparse(problem, x, y, warm_buffers, &warm_start), x,
+                       y);
+    }
+}
+
+/**
+ * @brief lapjv_internal on square problems with finite costs
+ */
+template<typename cost_t>
+void test_lapjv(std::mt19937 &rng, int num_trials)
+{
+    std::uniform_int_distribution<int> size(1, max_size);
+    std::uniform_int_distribution<int> value(0, 20);
+
+    LapjvBuffers<cost_t> buffers;
+    std::vector<int_t> x, y;
+    for (int trial = 0; trial < num_trials; trial++)
+    {
+        Problem<cost_t> problem;
+        problem.n_rows = problem.n_cols = size(rng);
+        problem.unassigned_cost = std::numeric_limits<cost_t>::infinity();
+        problem.cost.resize(static_cast<size_t>(problem.n_rows) * problem.n_cols);
+        for (cost_t &c: problem.cost)
+        {
+            c = static_cast<cost_t>(value(rng));
+        }
+
+        x.assign(problem.n_rows, -2);
+        y.assign(problem.n_cols, -2);
+        const int_t result = lapjv_internal<cost_t>(problem.n_rows, problem.cost.data(), x.data(), y.data(), buffers);
+        check_solution("lapjv", problem, result, x, y);
+    }
+}
+
+template<typename cost_t>
+int_t solve_auction(const Problem<cost_t> &problem, std::vector<int_t> &x, std::vector<int_t> &y,
+                    AuctionBuffers<cost_t> &buffers)
+{
+    x.assign(problem.n_rows, -2);
+    y.assign(problem.n_cols, -2);
+    return lsap_auction<cost_t>(problem.n_rows, problem.n_cols, problem.cost.data(), problem.unassigned_cost,
+                                x.data(), y.data(), buffers, static_cast<cost_t>(auction_epsilon));
+}
+
+/**
+ * @brief lsap_auction with every row assigned and with a finite unassigned_cost, within its optimality tolerance
+ */
+template<typename cost_t>
+void test_auction(std::mt19937 &rng, int num_trials)
+{
+    std::bernoulli_distribution coin(0.5);
+
+    AuctionBuffers<cost_t> buffers;
+    std::vector<int_t> x, y;
+    for (int trial = 0; trial < num_trials; trial++)
+    {
+        const Problem<cost_t> problem = make_problem<cost_t>(rng, coin(rng), coin(rng));
+        const double tolerance = (problem.n_rows + problem.n_cols) * auction_epsilon + 1e-6;
+        check_solution("auction", problem, solve_auction(problem, x, y, buffers), x, y, tolerance);
+    }
+}
+
+/**
+ * @brief lsap_auction on equal costs, zero or below epsilon, with every row assigned: the bids are then only epsilon
+ *  increments, which must not be mistaken for the unbounded prices of an infeasible problem
+ */
+template<typename cost_t>
+void test_auction_equal_costs()
+{
+    AuctionBuffers<cost_t> buffers;
+    std::vector<int_t> x, y;
+    for (const cost_t value: {cost_t(0), cost_t(1e-5), cost_t(1)})
+    {
+        for (int n = 1; n <= max_size; n++)
+        {
+            Problem<cost_t> problem;
+            problem.n_rows = problem.n_cols = n;
+            problem.unassigned_cost = std::numeric_limits<cost_t>::infinity();
+            problem.cost.assign(static_cast<size_t>(n) * n, value);
+
+            const double tolerance = 2 * n * auction_epsilon + 1e-6;
+            check_solution("auction with equal costs", problem, solve_auction(problem, x, y, buffers), x, y,
+                           tolerance);
+        }
+    }
+}
+
+template<typename cost_t>
+void run_tests(std::mt19937 &rng, int num_trials)
+{
+    test_complete_assignment<cost_t>(rng, num_trials);
+    test_rectangular_with_dummies<cost_t>(rng, num_trials);
+    test_warm_start<cost_t>(rng, num_trials);
+    test_lapjv<cost_t>(rng, num_trials);
+    test_auction<cost_t>(rng, num_trials);
+    test_auction_equal_costs<cost_t>();
+}
+}// namespace
+
+int main(int argc, char **argv)
+{
+    const int num_trials = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+    std::mt19937 rng(42);
+    run_tests<float>(rng, num_trials);
+    run_tests<double>(rng, num_trials);
+
+    if (num_failures > 0)
+    {
+        std::printf("%d check(s) failed\n", num_failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("All assignment solver checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <future>
+#include <map>
 #include <string>
 
 #include "GlobalMotionCompensation.h"
+#include "IdentityMemory.h"
 #include "ReID.h"
+#include "ThreadPool.h"
+#include "matching.h"
 #include "track.h"
 
 namespace botsort 
@@ -32,14 +37,61 @@ public:
 
 private:
     /**
-     * @brief Extract visual features from the given frame and bounding box
+     * @brief Build the association cost matrix between tracks and detections, fusing the IoU distance,
+     *  the embedding distance (if ReID is enabled) and the motion gating in a single pass
+     * 
+     * @param tracks Tracks used to create the cost matrix
+     * @param detections Tracks created from detections used to create the cost matrix
+     * @return CostMatrix Fused and masked cost matrix
+     */
+    CostMatrix
+    _association_distance(const std::vector<std::shared_ptr<Track>> &tracks,
+                          const std::vector<std::shared_ptr<Track>> &detections) const;
+
+    /**
+     * @brief Extract visual features from the given frame for all the given bounding boxes in one batched pass
      * 
      * @param frame Input frame
-     * @param bbox_tlwh Bounding box (top, left, width, height)
-     * @return FeatureVector Extracted visual features
+     * @param bboxes_tlwh Bounding boxes (top, left, width, height)
+     * @return FeatureMatrix Extracted visual features, one row per bounding box
+     */
+    FeatureMatrix
+    _extract_features(const cv::Mat &frame,
+                      const std::vector<cv::Rect_<float>> &bboxes_tlwh);
+
+    /**
+     * @brief Extract visual features for the given detections that do not have any yet, in one batched pass
+     * 
+     * @param frame Input frame
+     * @param detections Tracks created from detections
+     */
+    void _extract_missing_features(
+            const cv::Mat &frame,
+            const std::vector<std::shared_ptr<Track>> &detections);
+
+    /**
+     * @brief Select the detections which need visual features when ReID runs lazily.
+     *  A detection needs features when it has no candidate track inside the IoU gate, several candidate tracks,
+     *  or a single candidate track that is either lost, also a candidate for other detections, or whose last
+     *  feature is lazy_reid_refresh_interval frames old, so that tracks matched by IoU alone keep their
+     *  appearance up to date.
+     * 
+     * @param iou_dists_mask IoU distance mask between tracks and detections (1 for pairs outside the IoU gate)
+     * @param tracks Tracks used to create the mask
+     * @return std::vector<int> Indices of the detections needing visual features
+     */
+    std::vector<int> _select_ambiguous_detections(
+            const CostMatrix &iou_dists_mask,
+            const std::vector<std::shared_ptr<Track>> &tracks) const;
+
+    /**
+     * @brief Get the motion model for tracks of the given class: the per-class override if any,
+     *  the tracker motion model otherwise
+     * 
+     * @param class_id Class ID of the track
+     * @return std::shared_ptr<const MotionModel> Motion model, shared by all the tracks using it
      */
-    FeatureVector _extract_features(const cv::Mat &frame,
-                                    const cv::Rect_<float> &bbox_tlwh);
+    std::shared_ptr<const MotionModel> _motion_model_for(uint8_t class_id) const;
 
     /**
      * @brief Merge the given track lists
@@ -82,6 +134,22 @@ private:
             std::vector<std::shared_ptr<Track>> &tracks_list_b);
 
 
+    /**
+     * @brief Schedule a task of the per-frame task graph on the thread pool.
+     *  Without a thread pool, the task is deferred and runs when its result is requested.
+     * 
+     * @param task Callable without arguments
+     * @return std::future Future holding the result of the task
+     */
+    template<typename F>
+    auto _schedule(F &&task) -> std::future<std::invoke_result_t<F>>
+    {
+        if (_thread_pool)
+            return _thread_pool->submit(std::forward<F>(task));
+        return std::async(std::launch::deferred, std::forward<F>(task));
+    }
+
+
     /**
      * @brief Load tracker parameters from the given config file
      * 
@@ -92,17 +160,36 @@ private:
 
 private:
     std::string _gmc_method_name;
-    bool _reid_enabled, _gmc_enabled;
-    uint8_t _track_buffer, _frame_rate, _buffer_size, _max_time_lost;
+    bool _reid_enabled, _lazy_reid, _gmc_enabled, _gallery_matching,
+            _long_term_reid_enabled, _assignment_warm_start;
+    uint8_t _track_buffer, _frame_rate, _buffer_size, _max_time_lost,
+            _num_worker_threads;
+    int _feat_history_size, _long_term_capacity, _ivf_lists, _ivf_probes,
+            _kalman_steady_state_after;
+    unsigned int _long_term_max_age, _long_lost_thresh,
+            _lazy_reid_refresh_interval;
     float _track_high_thresh, _track_low_thresh, _new_track_thresh,
-            _match_thresh, _proximity_thresh, _appearance_thresh, _lambda;
+            _match_thresh, _proximity_thresh, _appearance_thresh, _lambda,
+            _long_term_thresh;
     unsigned int _frame_id;
 
     std::vector<std::shared_ptr<Track>> _tracked_tracks;
     std::vector<std::shared_ptr<Track>> _lost_tracks;
+    std::vector<std::shared_ptr<Track>> _long_lost_tracks;
 
-    std::unique_ptr<KalmanFilter> _kalman_filter;
+    MotionModelType _motion_model_type;
+    std::map<uint8_t, MotionModelType> _class_motion_model_types;
+    std::map<MotionModelType, std::shared_ptr<const MotionModel>>
+            _motion_models;
     std::unique_ptr<GlobalMotionCompensation> _gmc_algo;
     std::unique_ptr<ReIDModel> _reid_model;
+    std::shared_ptr<EmbeddingArena> _embedding_arena;
+    std::unique_ptr<IdentityMemory> _identity_memory;
+    std::unique_ptr<ThreadPool> _thread_pool;
+    AssignmentWorkspace _assignment_workspace;
+    AssociationWarmStart _first_association_warm_start;
+    AssignmentOptions _first_assignment_options, _second_assignment_options;
+    AssignmentOptions _long_lost_assignment_options,
+            _unconfirmed_assignment_options;
 };
 }
\ No newline at end of file
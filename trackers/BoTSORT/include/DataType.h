@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/Dense>
@@ -22,6 +23,11 @@ constexpr uint8_t KALMAN_MEASUREMENT_SPACE_DIM = 4;
  * @brief Detection vector with DET_ELEMENTS elements.
  */
 using DetVec = Eigen::Matrix<float, 1, DET_ELEMENTS>;
+/**
+ * @brief Bounding box with DET_ELEMENTS elements in the format (top left x, top left y, width, height).
+ * Fixed-size and trivially copyable, so it can be passed around the association code without heap allocations.
+ */
+using BBox = std::array<float, DET_ELEMENTS>;
 /**
  * @brief Struct representing a detection
  * 
@@ -47,6 +53,15 @@ using FeatureVector = Eigen::Matrix<float, 1, FEATURE_DIM>;
  */
 using FeatureMatrix = Eigen::Matrix<float, Eigen::Dynamic, FEATURE_DIM>;
 
+/**
+ * @brief Distance metric used to compare feature vectors
+ */
+enum class DistanceMetric
+{
+    Euclidean = 0,
+    Cosine
+};
+
 
 // Kalman Filter
 /**
@@ -76,6 +91,11 @@ using KFMeasSpaceMatrix = Eigen::Matrix<float, KALMAN_MEASUREMENT_SPACE_DIM,
  * @brief Kalman Filter measurement space data containing a mean vector and a covariance matrix.
  */
 using KFDataMeasurementSpace = std::pair<KFMeasSpaceVec, KFMeasSpaceMatrix>;
+/**
+ * @brief Batch of measurements, one measurement space vector per column.
+ */
+using KFMeasSpaceBatch =
+        Eigen::Matrix<float, KALMAN_MEASUREMENT_SPACE_DIM, Eigen::Dynamic>;
 
 
 // Camera Motion Compensation
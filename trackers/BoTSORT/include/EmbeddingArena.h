@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "DataType.h"
+
+namespace botsort
+{
+
+class EmbeddingArena;
+
+/**
+ * @brief Row-major view of feature vectors stored contiguously, one feature vector per row.
+ */
+using FeatureRowsView =
+        Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, FEATURE_DIM,
+                                       Eigen::RowMajor>>;
+
+/**
+ * @brief Fixed-capacity ring buffer of feature vectors, stored in a block of an EmbeddingArena.
+ *  Once the buffer is full, the oldest feature vector is overwritten.
+ */
+class FeatureGallery
+{
+public:
+    FeatureGallery(std::shared_ptr<EmbeddingArena> arena, float *block,
+                   int capacity);
+    ~FeatureGallery();
+
+    FeatureGallery(const FeatureGallery &) = delete;
+    FeatureGallery &operator=(const FeatureGallery &) = delete;
+
+    /**
+     * @brief Add a feature vector to the gallery, overwriting the oldest one if the gallery is full
+     *
+     * @param feat Feature vector
+     */
+    void push(const FeatureVector &feat);
+
+    /**
+     * @brief Get the number of feature vectors stored in the gallery
+     *
+     * @return int Number of feature vectors
+     */
+    int size() const;
+
+    /**
+     * @brief Get the stored feature vectors as a (size x FEATURE_DIM) matrix.
+     *  Rows are in ring buffer order, not in chronological order.
+     *
+     * @return FeatureRowsView Stored feature vectors
+     */
+    FeatureRowsView features() const;
+
+private:
+    std::shared_ptr<EmbeddingArena> _arena;
+    float *_block;
+    int _capacity, _size, _next;
+};
+
+
+/**
+ * @brief Per-tracker arena holding the feature galleries of all tracks.
+ *  Galleries are carved out of large 64-byte aligned pages and recycled through a free list,
+ *  so tracks coming and going do not cause any heap allocation once the arena has grown.
+ */
+class EmbeddingArena : public std::enable_shared_from_this<EmbeddingArena>
+{
+public:
+    /**
+     * @brief Construct a new Embedding Arena object
+     *
+     * @param gallery_capacity Number of feature vectors held by each gallery
+     * @param galleries_per_page Number of galleries allocated at once when the arena grows
+     */
+    explicit EmbeddingArena(int gallery_capacity, int galleries_per_page = 32);
+
+    /**
+     * @brief Get an empty gallery from the arena. The gallery returns its storage to the arena when destroyed.
+     *
+     * @return std::unique_ptr<FeatureGallery> Empty gallery
+     */
+    std::unique_ptr<FeatureGallery> acquire();
+
+    /**
+     * @brief Get the number of feature vectors held by each gallery
+     *
+     * @return int Gallery capacity
+     */
+    int gallery_capacity() const;
+
+private:
+    friend class FeatureGallery;
+
+    void _release(float *block);
+    void _grow();
+
+private:
+    static constexpr size_t _alignment = 64;
+
+    int _gallery_capacity, _galleries_per_page;
+    std::vector<std::unique_ptr<float, decltype(&std::free)>> _pages;
+    std::vector<float *> _free_blocks;
+    std::mutex _mutex;
+};
+
+}// namespace botsort
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "DataType.h"
+
+namespace botsort
+{
+
+/**
+ * @brief Long-term memory of the identities of removed tracks, used to re-identify people after long absences.
+ *  Identities are stored by their (normalized) smoothed feature in an IVF-flat index: features are partitioned into
+ *  inverted lists around k-means centroids, and a query only scans the lists of its closest centroids.
+ *  Memory is bounded, the oldest identities are evicted when the memory is full or when they exceed the maximum age.
+ */
+class IdentityMemory
+{
+public:
+    /**
+     * @brief Identity recovered from the memory
+     *
+     * int track_id: Track ID of the identity
+     * float distance: Cosine distance between the query feature and the stored feature
+     */
+    struct Match
+    {
+        int track_id;
+        float distance;
+    };
+
+    /**
+     * @brief Construct a new Identity Memory object
+     *
+     * @param capacity Maximum number of identities kept in the memory
+     * @param num_lists Number of inverted lists (k-means centroids) of the index
+     * @param num_probes Number of inverted lists scanned by a query
+     * @param max_age Number of frames after which an identity is evicted
+     */
+    IdentityMemory(int capacity, int num_lists, int num_probes,
+                   unsigned int max_age);
+
+    /**
+     * @brief Add the identity of a removed track to the memory, evicting the oldest identity if the memory is full
+     *
+     * @param track_id Track ID
+     * @param class_id Class ID of the track
+     * @param feat Smoothed feature of the track
+     * @param frame_id Frame in which the track was last seen
+     */
+    void insert(int track_id, uint8_t class_id, const FeatureVector &feat,
+                unsigned int frame_id);
+
+    /**
+     * @brief Find the closest identity of the same class within max_distance, and remove it from the memory
+     *
+     * @param feat Query feature
+     * @param class_id Class ID of the query
+     * @param max_distance Maximum cosine distance to accept a match
+     * @return std::optional<Match> Recovered identity, std::nullopt if there is none
+     */
+    std::optional<Match> query(const FeatureVector &feat, uint8_t class_id,
+                               float max_distance);
+
+    /**
+     * @brief Evict the identities that have not been seen for more than max_age frames
+     *
+     * @param frame_id Current frame ID
+     */
+    void evict_expired(unsigned int frame_id);
+
+    /**
+     * @brief Get the number of identities stored in the memory
+     *
+     * @return size_t Number of identities
+     */
+    size_t size() const;
+
+private:
+    using FeatureRows = Eigen::Matrix<float, Eigen::Dynamic, FEATURE_DIM,
+                                      Eigen::RowMajor>;
+
+    /**
+     * @brief Inverted list, features are stored contiguously, one feature per FEATURE_DIM floats
+     */
+    struct InvertedList
+    {
+        std::vector<float> features;
+        std::vector<int> track_ids;
+        std::vector<uint8_t> class_ids;
+        std::vector<unsigned int> frame_ids;
+    };
+
+    /**
+     * @brief Location of an identity in the index
+     */
+    struct Location
+    {
+        int list;
+        size_t slot;
+    };
+
+    /**
+     * @brief Append a feature to the inverted list of its closest centroid
+     */
+    void _add_to_index(int track_id, uint8_t class_id, const float *feat,
+                       unsigned int frame_id);
+
+    /**
+     * @brief Remove an identity from its inverted list, the last entry of the list takes its slot
+     */
+    void _remove(int track_id);
+
+    /**
+     * @brief Get the index of the closest centroid to the given feature
+     */
+    int _closest_list(const float *feat) const;
+
+    /**
+     * @brief Run k-means over the stored features and rebuild the inverted lists around the new centroids
+     */
+    void _train();
+
+private:
+    static constexpr int _kmeans_iterations = 10;
+    static constexpr int _min_points_per_list = 4;
+
+    int _capacity, _num_lists, _num_probes;
+    unsigned int _max_age;
+
+    // Untrained index: a single list scanned exhaustively
+    FeatureRows _centroids;
+    std::vector<InvertedList> _lists;
+    std::unordered_map<int, Location> _locations;
+
+    // Identities in insertion order, entries of identities already removed are skipped lazily
+    std::deque<std::pair<int, unsigned int>> _insertion_order;
+    size_t _inserts_since_training;
+};
+
+}// namespace botsort
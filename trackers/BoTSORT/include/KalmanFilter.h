@@ -1,21 +1,36 @@
 #pragma once
 
 #include "DataType.h"
+#include "MotionModel.h"
 
 namespace botsort
 {
 
 namespace bot_kalman
 {
-class KalmanFilter
+class KalmanFilter : public MotionModel
 {
 public:
     /**
      * @brief Construct a new Kalman Filter object.
      * 
      * @param dt Time interval between consecutive measurements (dt = 1/FPS)
+     * @param steady_state_after Number of consecutive updates after which a track uses the steady-state gain
+     *  instead of propagating its covariance (see predict_steady_state), 0 disables it
      */
-    explicit KalmanFilter(double dt);
+    explicit KalmanFilter(double dt, int steady_state_after = 0);
+
+    /**
+     * @brief Whether a track that was updated in every frame has converged to the steady state.
+     * 
+     * @param consecutive_updates Number of consecutive updates of the track.
+     * @return bool True if predict_steady_state and update_steady_state should be used for the track.
+     */
+    bool in_steady_state(int consecutive_updates) const override
+    {
+        return _steady_state_after > 0 &&
+               consecutive_updates >= _steady_state_after;
+    }
 
     /**
      * @brief Initialize the Kalman Filter with a measurement (detection).
@@ -23,15 +38,41 @@ public:
      * @param det Detection [x-center, y-center, width, height].
      * @return KFDataStateSpace Kalman filter state space data [mean, covariance].
      */
-    KFDataStateSpace init(const DetVec &det) const;
+    KFDataStateSpace init(const DetVec &det) const override;
 
     /**
      * @brief Predict the next Kalman Filter state space data (mean, covariance) given the current state space data.
+     *  The state transition F = [I, dt*I; 0, I] is applied block-wise (see _transition), without 8x8 products.
+     * 
+     * @param mean Current Kalman Filter state space mean.
+     * @param covariance Current Kalman Filter state space covariance.
+     */
+    void predict(KFStateSpaceVec &mean,
+                 KFStateSpaceMatrix &covariance) const override;
+
+    /**
+     * @brief Predict the Kalman Filter state space data (mean, covariance) several steps ahead, in closed form.
+     *  Equivalent to calling predict() steps times when the width and height velocities are zero, which keeps
+     *  the process noise constant over the steps.
      * 
      * @param mean Current Kalman Filter state space mean.
      * @param covariance Current Kalman Filter state space covariance.
+     * @param steps Number of prediction steps.
+     */
+    void predict(KFStateSpaceVec &mean, KFStateSpaceMatrix &covariance,
+                 int steps) const override;
+
+    /**
+     * @brief Predict the next state of a track that is updated in every frame, without propagating the covariance.
+     *  The process and measurement noises are proportional to the squared box size, so the covariance of such a
+     *  track converges to the steady-state covariance of a unit box scaled by the squared size of each axis,
+     *  and the Kalman gain to a constant. The covariance is set to that scaled steady-state prior.
+     * 
+     * @param mean Current Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance, overwritten.
      */
-    void predict(KFStateSpaceVec &mean, KFStateSpaceMatrix &covariance);
+    void predict_steady_state(KFStateSpaceVec &mean,
+                              KFStateSpaceMatrix &covariance) const override;
 
     /**
      * @brief Project the Kalman Filter state space data (mean, covariance) to measurement space.
@@ -40,11 +81,14 @@ public:
      * @param covariance Kalman Filter state space covariance.
      * @return KFDataMeasurementSpace Kalman Filter measurement space data [mean, covariance]. 
      */
-    KFDataMeasurementSpace project(const KFStateSpaceVec &mean,
-                                   const KFStateSpaceMatrix &covariance) const;
+    KFDataMeasurementSpace
+    project(const KFStateSpaceVec &mean,
+            const KFStateSpaceMatrix &covariance) const override;
 
     /**
      * @brief Update the Kalman Filter state space data (mean, covariance) given the measurement (detection).
+     *  With H = [I, 0], the gain only involves the first four columns of the covariance and the closed-form
+     *  inverse of the 4x4 innovation covariance.
      * 
      * @param mean Kalman Filter state space mean.
      * @param covariance Kalman Filter state space covariance.
@@ -53,23 +97,22 @@ public:
      */
     KFDataStateSpace update(const KFStateSpaceVec &mean,
                             const KFStateSpaceMatrix &covariance,
-                            const DetVec &measurement);
+                            const DetVec &measurement) const override;
 
     /**
-     * @brief Compute the gating distance between the Kalman Filter state space data (mean, covariance) and the 
-     * measurements (detections) using the Mahalanobis distance.
+     * @brief Update a track predicted with predict_steady_state, with the precomputed steady-state gain.
+     *  The covariance is updated with that gain: it gives the scaled steady-state posterior, and keeps
+     *  the camera motion applied to the prior since predict_steady_state.
      * 
      * @param mean Kalman Filter state space mean.
-     * @param covariance Kalman Filter state space covariance.
-     * @param measurements Detection [x-center, y-center, width, height].
-     * @param only_position If true, only the position (x-center, y-center) is used to compute the gating distance.
-     * @return Eigen::Matrix<float, 1, Eigen::Dynamic> Gating distance.
+     * @param covariance Kalman Filter state space covariance, predicted with predict_steady_state.
+     * @param measurement Detection [x-center, y-center, width, height].
+     * @return KFDataStateSpace Updated Kalman Filter state space data [mean, covariance].
      */
-    Eigen::Matrix<float, 1, Eigen::Dynamic>
-    gating_distance(const KFStateSpaceVec &mean,
-                    const KFStateSpaceMatrix &covariance,
-                    const std::vector<DetVec> &measurements,
-                    bool only_position = false) const;
+    KFDataStateSpace
+    update_steady_state(const KFStateSpaceVec &mean,
+                        const KFStateSpaceMatrix &covariance,
+                        const DetVec &measurement) const override;
 
 private:
     /**
@@ -79,14 +122,41 @@ private:
      */
     void _init_kf_matrices(double dt);
 
+    /**
+     * @brief Apply the state transition [I, step*I; 0, I] to the state space data in place, block-wise:
+     *  the covariance update only needs 4x4 additions.
+     * 
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @param step Time elapsed.
+     */
+    static void _transition(KFStateSpaceVec &mean,
+                            KFStateSpaceMatrix &covariance, float step);
 
-public:
-    static constexpr double chi2inv95[10] = {0,      3.8415, 5.9915, 7.8147,
-                                             9.4877, 11.070, 12.592, 14.067,
-                                             15.507, 16.919};
+    /**
+     * @brief Compute the steady-state gain and prior covariance of a unit box, by iterating the filter on the
+     *  [position, velocity] pair of a single axis (the axes are independent and share the same noise weights).
+     */
+    void _init_steady_state();
+
+    /**
+     * @brief Set the covariance to a steady-state covariance of a unit box, scaled by the squared size of each axis.
+     * 
+     * @param mean Kalman Filter state space mean, gives the box size.
+     * @param unit_covariance Steady-state [position, velocity] covariance of one axis of a unit box.
+     * @param covariance Kalman Filter state space covariance, overwritten.
+     */
+    static void _set_steady_state_covariance(const KFStateSpaceVec &mean,
+                                             const Eigen::Matrix2f &unit_covariance,
+                                             KFStateSpaceMatrix &covariance);
 
 private:
     float _std_weight_position, _std_weight_velocity;
+    float _dt;
+
+    int _steady_state_after;
+    float _steady_gain_position, _steady_gain_velocity;
+    Eigen::Matrix2f _steady_prior_covariance;
 
     Eigen::Matrix<float, KALMAN_STATE_SPACE_DIM, KALMAN_STATE_SPACE_DIM>
             _state_transition_matrix;
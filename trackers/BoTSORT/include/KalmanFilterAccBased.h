@@ -1,13 +1,14 @@
 #pragma once
 
 #include "DataType.h"
+#include "MotionModel.h"
 
 namespace botsort
 {
 
 namespace acc_kalman
 {
-class KalmanFilter
+class KalmanFilter : public MotionModel
 {
 public:
     /**
@@ -23,7 +24,7 @@ public:
      * @param det Detection [x-center, y-center, width, height].
      * @return KFDataStateSpace Kalman filter state space data [mean, covariance].
      */
-    KFDataStateSpace init(const DetVec &det) const;
+    KFDataStateSpace init(const DetVec &det) const override;
 
     /**
      * @brief Predict the next Kalman Filter state space data (mean, covariance) given the current state space data.
@@ -31,7 +32,8 @@ public:
      * @param mean Current Kalman Filter state space mean.
      * @param covariance Current Kalman Filter state space covariance.
      */
-    void predict(KFStateSpaceVec &mean, KFStateSpaceMatrix &covariance);
+    void predict(KFStateSpaceVec &mean,
+                 KFStateSpaceMatrix &covariance) const override;
 
     /**
      * @brief Project the Kalman Filter state space data (mean, covariance) to measurement space.
@@ -40,9 +42,21 @@ public:
      * @param covariance Kalman Filter state space covariance.
      * @return KFDataMeasurementSpace Kalman Filter measurement space data [mean, covariance]. 
      */
+    KFDataMeasurementSpace
+    project(const KFStateSpaceVec &mean,
+            const KFStateSpaceMatrix &covariance) const override;
+
+    /**
+     * @brief Project the Kalman Filter state space data (mean, covariance) to measurement space.
+     * 
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @param motion_compensated If true, use the larger detection noise of motion compensated frames.
+     * @return KFDataMeasurementSpace Kalman Filter measurement space data [mean, covariance]. 
+     */
     KFDataMeasurementSpace project(const KFStateSpaceVec &mean,
                                    const KFStateSpaceMatrix &covariance,
-                                   bool motion_compensated = false) const;
+                                   bool motion_compensated) const;
 
     /**
      * @brief Update the Kalman Filter state space data (mean, covariance) given the measurement (detection).
@@ -54,23 +68,7 @@ public:
      */
     KFDataStateSpace update(const KFStateSpaceVec &mean,
                             const KFStateSpaceMatrix &covariance,
-                            const DetVec &measurement);
-
-    /**
-     * @brief Compute the gating distance between the Kalman Filter state space data (mean, covariance) and the 
-     * measurements (detections) using the Mahalanobis distance.
-     * 
-     * @param mean Kalman Filter state space mean.
-     * @param covariance Kalman Filter state space covariance.
-     * @param measurements Detections [x-center, y-center, width, height].
-     * @param only_position If true, only the position (x-center, y-center) is used to compute the gating distance.
-     * @return Eigen::Matrix<float, 1, Eigen::Dynamic> Gating distance.
-     */
-    Eigen::Matrix<float, 1, Eigen::Dynamic>
-    gating_distance(const KFStateSpaceVec &mean,
-                    const KFStateSpaceMatrix &covariance,
-                    const std::vector<DetVec> &measurements,
-                    bool only_position = false) const;
+                            const DetVec &measurement) const override;
 
 private:
     /**
@@ -80,12 +78,6 @@ private:
      */
     void _init_kf_matrices(double dt);
 
-
-public:
-    static constexpr double chi2inv95[10] = {0,      3.8415, 5.9915, 7.8147,
-                                             9.4877, 11.070, 12.592, 14.067,
-                                             15.507, 16.919};
-
 private:
     float _init_pos_weight, _init_vel_weight;
     float _std_factor_acceleration, _std_offset_acceleration;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "DataType.h"
+#include "MotionModel.h"
+
+namespace botsort
+{
+
+namespace static_kalman
+{
+/**
+ * @brief Kalman filter of parked objects: the velocity is pinned to zero and the position only drifts with a
+ *  process noise proportional to the box size. The state keeps the [x, y, w, h, vx, vy, vw, vh] layout of the
+ *  other motion models, with a zero velocity block, so tracks and matching handle all of them alike.
+ */
+class KalmanFilter : public MotionModel
+{
+public:
+    /**
+     * @brief Construct a new Kalman Filter object. It does not depend on the frame rate, as the position does not move.
+     */
+    KalmanFilter();
+
+    /**
+     * @brief Initialize the Kalman Filter with a measurement (detection).
+     * 
+     * @param det Detection [x-center, y-center, width, height].
+     * @return KFDataStateSpace Kalman filter state space data [mean, covariance].
+     */
+    KFDataStateSpace init(const DetVec &det) const override;
+
+    /**
+     * @brief Predict the next Kalman Filter state space data (mean, covariance): the mean does not move and
+     *  the position variance grows with the drift noise.
+     * 
+     * @param mean Current Kalman Filter state space mean.
+     * @param covariance Current Kalman Filter state space covariance.
+     */
+    void predict(KFStateSpaceVec &mean,
+                 KFStateSpaceMatrix &covariance) const override;
+
+    /**
+     * @brief Predict the Kalman Filter state space data several steps ahead, in closed form.
+     * 
+     * @param mean Current Kalman Filter state space mean.
+     * @param covariance Current Kalman Filter state space covariance.
+     * @param steps Number of prediction steps.
+     */
+    void predict(KFStateSpaceVec &mean, KFStateSpaceMatrix &covariance,
+                 int steps) const override;
+
+    /**
+     * @brief Project the Kalman Filter state space data (mean, covariance) to measurement space.
+     * 
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @return KFDataMeasurementSpace Kalman Filter measurement space data [mean, covariance]. 
+     */
+    KFDataMeasurementSpace
+    project(const KFStateSpaceVec &mean,
+            const KFStateSpaceMatrix &covariance) const override;
+
+    /**
+     * @brief Update the Kalman Filter state space data (mean, covariance) given the measurement (detection).
+     *  Only the position block is updated, the velocity stays zero.
+     * 
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @param measurement Detection [x-center, y-center, width, height].
+     * @return KFDataStateSpace Updated Kalman Filter state space data [mean, covariance].
+     */
+    KFDataStateSpace update(const KFStateSpaceVec &mean,
+                            const KFStateSpaceMatrix &covariance,
+                            const DetVec &measurement) const override;
+
+private:
+    /**
+     * @brief Zero the velocity and its covariance, left over when the track used another motion model before.
+     */
+    static void _pin_velocity(KFStateSpaceVec &mean,
+                              KFStateSpaceMatrix &covariance);
+
+    float _std_weight_position, _std_weight_drift;
+};
+}// namespace static_kalman
+
+}
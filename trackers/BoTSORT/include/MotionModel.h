@@ -0,0 +1,166 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "DataType.h"
+
+namespace botsort
+{
+
+/**
+ * @brief Motion models of the tracks, all Kalman filters on the state [x, y, w, h, vx, vy, vw, vh]
+ *
+ * ConstantVelocity: constant velocity, noise proportional to the box size (bot_kalman::KalmanFilter)
+ * Acceleration: velocity decaying with a half-life and coupled across axes, process noise driven by the
+ *  acceleration (acc_kalman::KalmanFilter)
+ * Static: parked objects, the velocity is pinned to zero and the position only drifts (static_kalman::KalmanFilter)
+ */
+enum class MotionModelType
+{
+    ConstantVelocity = 0,
+    Acceleration,
+    Static
+};
+
+class MotionModel
+{
+public:
+    virtual ~MotionModel() = default;
+
+    /**
+     * @brief Initialize the state space data of a track from a measurement (detection).
+     *
+     * @param det Detection [x-center, y-center, width, height].
+     * @return KFDataStateSpace Kalman filter state space data [mean, covariance].
+     */
+    virtual KFDataStateSpace init(const DetVec &det) const = 0;
+
+    /**
+     * @brief Predict the next state space data (mean, covariance) given the current state space data.
+     *
+     * @param mean Current Kalman Filter state space mean.
+     * @param covariance Current Kalman Filter state space covariance.
+     */
+    virtual void predict(KFStateSpaceVec &mean,
+                         KFStateSpaceMatrix &covariance) const = 0;
+
+    /**
+     * @brief Predict the state space data several steps ahead. Calls predict() steps times unless the model has a
+     *  closed form.
+     *
+     * @param mean Current Kalman Filter state space mean.
+     * @param covariance Current Kalman Filter state space covariance.
+     * @param steps Number of prediction steps.
+     */
+    virtual void predict(KFStateSpaceVec &mean, KFStateSpaceMatrix &covariance,
+                         int steps) const;
+
+    /**
+     * @brief Project the state space data (mean, covariance) to measurement space.
+     *
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @return KFDataMeasurementSpace Kalman Filter measurement space data [mean, covariance].
+     */
+    virtual KFDataMeasurementSpace
+    project(const KFStateSpaceVec &mean,
+            const KFStateSpaceMatrix &covariance) const = 0;
+
+    /**
+     * @brief Update the state space data (mean, covariance) given the measurement (detection).
+     *
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @param measurement Detection [x-center, y-center, width, height].
+     * @return KFDataStateSpace Updated Kalman Filter state space data [mean, covariance].
+     */
+    virtual KFDataStateSpace update(const KFStateSpaceVec &mean,
+                                    const KFStateSpaceMatrix &covariance,
+                                    const DetVec &measurement) const = 0;
+
+    /**
+     * @brief Whether a track that was updated in every frame has converged to the steady state, in which case
+     *  predict_steady_state and update_steady_state are used for it. Never by default.
+     *
+     * @param consecutive_updates Number of consecutive updates of the track.
+     */
+    virtual bool in_steady_state(int /*consecutive_updates*/) const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Predict a track in the steady state, predict() by default.
+     */
+    virtual void predict_steady_state(KFStateSpaceVec &mean,
+                                      KFStateSpaceMatrix &covariance) const
+    {
+        predict(mean, covariance);
+    }
+
+    /**
+     * @brief Update a track in the steady state, update() by default.
+     */
+    virtual KFDataStateSpace
+    update_steady_state(const KFStateSpaceVec &mean,
+                        const KFStateSpaceMatrix &covariance,
+                        const DetVec &measurement) const
+    {
+        return update(mean, covariance, measurement);
+    }
+
+    /**
+     * @brief Compute the gating distance between the Kalman Filter state space data (mean, covariance) and the
+     * measurements (detections) using the Mahalanobis distance.
+     *
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @param measurements Detection [x-center, y-center, width, height].
+     * @param only_position If true, only the position (x-center, y-center) is used to compute the gating distance.
+     * @return Eigen::Matrix<float, 1, Eigen::Dynamic> Gating distance.
+     */
+    Eigen::Matrix<float, 1, Eigen::Dynamic>
+    gating_distance(const KFStateSpaceVec &mean,
+                    const KFStateSpaceMatrix &covariance,
+                    const std::vector<DetVec> &measurements,
+                    bool only_position = false) const;
+
+    /**
+     * @brief Compute the gating distance (squared Mahalanobis distance) between the Kalman Filter state space data
+     *  (mean, covariance) and a batch of measurements. The projected covariance is factorized once with a fixed-size
+     *  Cholesky decomposition, then every measurement is whitened with a fixed-size matrix-vector product.
+     *
+     * @param mean Kalman Filter state space mean.
+     * @param covariance Kalman Filter state space covariance.
+     * @param measurements Detections [x-center, y-center, width, height], one per column.
+     * @param distances Output gating distance, one per measurement. Must have as many elements as there are measurements.
+     * @param only_position If true, only the position (x-center, y-center) is used to compute the gating distance.
+     */
+    void gating_distance(const KFStateSpaceVec &mean,
+                         const KFStateSpaceMatrix &covariance,
+                         const KFMeasSpaceBatch &measurements,
+                         Eigen::Ref<Eigen::RowVectorXf> distances,
+                         bool only_position = false) const;
+
+    /**
+     * @brief Create a motion model.
+     *
+     * @param type Motion model to create
+     * @param dt Time interval between consecutive measurements (dt = 1/FPS)
+     * @param steady_state_after Number of consecutive updates after which a track uses the steady-state gain,
+     *  0 disables it. Only used by the constant velocity model
+     * @return std::shared_ptr<MotionModel> Motion model, shared by the tracks using it
+     */
+    static std::shared_ptr<MotionModel> create(MotionModelType type, double dt,
+                                               int steady_state_after = 0);
+
+public:
+    static constexpr double chi2inv95[10] = {0,      3.8415, 5.9915, 7.8147,
+                                             9.4877, 11.070, 12.592, 14.067,
+                                             15.507, 16.919};
+
+    static std::map<std::string, MotionModelType> motion_model_map;
+};
+}// namespace botsort
@@ -13,30 +13,88 @@ public:
     ReIDModel(const std::string &config_path, const std::string &onnx_model_path);
     ~ReIDModel() = default;
 
-    void pre_process(cv::Mat &image);
-    FeatureVector extract_features(cv::Mat &image);
+    FeatureVector extract_features(const cv::Mat &image);
 
-    const std::string &get_distance_metric() const {
+    /**
+     * @brief Extract features for all the given bounding boxes of a frame.
+     *  Crops are preprocessed in parallel into one contiguous NCHW tensor and
+     *  inference is run in batches of at most batch_size crops.
+     *
+     * @param frame Input frame
+     * @param bboxes_tlwh Bounding boxes (top left x, top left y, width, height)
+     * @return FeatureMatrix One feature row per bounding box
+     */
+    FeatureMatrix extract_features(const cv::Mat &frame,
+                                   const std::vector<cv::Rect_<float>> &bboxes_tlwh);
+
+    /**
+     * @brief Extract features for already cropped images, batched like
+     *  extract_features(frame, bboxes_tlwh).
+     *
+     * @param crops Image crops, of any size
+     * @return FeatureMatrix One feature row per crop
+     */
+    FeatureMatrix extract_features_batch(const std::vector<cv::Mat> &crops);
+
+    DistanceMetric get_distance_metric() const {
         return _distance_metric;
     }
 
 private:
     void _load_params_from_config(const std::string &config_path);
     void _initialize_onnx_session(const std::string &model_path);
+    void _pre_process_into(const cv::Mat &frame, const cv::Rect_<float> &bbox_tlwh,
+                           float *tensor_slot) const;
+    void _pre_process_into(const cv::Mat &crop, float *tensor_slot) const;
+
+    /**
+     * @brief Resize the given region of a BGR 8-bit image into a tensor slot in
+     *  one pass: bilinear sampling with the pixel center convention of
+     *  cv::resize (INTER_LINEAR), optional BGR->RGB, scaling to [0, 1] and
+     *  HWC->CHW, without intermediate images.
+     *
+     * @param image Source image (CV_8UC3)
+     * @param roi Region of the image to resize, inside the image
+     * @param tensor_slot Slot of one crop in the NCHW tensor
+     */
+    void _warp_into(const cv::Mat &image, const cv::Rect &roi, float *tensor_slot) const;
+
+    /**
+     * @brief Make room for num_crops preprocessed crops in the batch tensor,
+     *  padded to whole batches for models with a fixed batch axis.
+     */
+    void _reserve_batch_tensor(int num_crops);
+
+    /**
+     * @brief Run inference on the first num_crops crops of the batch tensor,
+     *  in chunks of at most _max_batch_size crops.
+     */
+    FeatureMatrix _run_inference(int num_crops);
 
 private:
     cv::Size _input_size;
-    std::string _onnx_model_path, _distance_metric;
-    std::string _input_layer_name;
-    bool _swap_rb;
+    DistanceMetric _distance_metric;
+    bool _swap_rb, _dynamic_batch;
+    int _batch_size, _max_batch_size;
+
+    // ONNX Runtime session settings
+    bool _enable_fp16, _enable_tf32, _parallel_execution, _enable_cpu_mem_arena,
+            _enable_mem_pattern;
+    int _intra_op_num_threads, _inter_op_num_threads;
+    GraphOptimizationLevel _graph_optimization_level;
+    std::vector<std::string> _execution_providers;
     
     // ONNX Runtime members
     Ort::Env _env;
     Ort::SessionOptions _session_options;
     std::unique_ptr<Ort::Session> _session;
-    std::vector<float> _input_tensor_values;
-    std::vector<int64_t> _input_tensor_shape;
+    std::unique_ptr<Ort::IoBinding> _io_binding;
+    Ort::MemoryInfo _memory_info{nullptr};
+    std::vector<float> _batch_tensor_values;
+    std::vector<float> _output_tensor_values;
+    std::vector<int64_t> _output_tensor_shape;
     std::vector<std::string> _input_node_names;
     std::vector<std::string> _output_node_names;
+    std::vector<const char *> _input_names_char, _output_names_char;
 };
 }
\ No newline at end of file
@@ -2,10 +2,13 @@
 
 #include <iostream>
 #include <tuple>
+#include <unordered_map>
 
 #include "DataType.h"
+#include "ThreadPool.h"
 
 #include "track.h"
+#include "utils.h"
 
 namespace botsort
 {
@@ -37,65 +40,147 @@ CostMatrix iou_distance(const std::vector<std::shared_ptr<Track>> &tracks,
 
 /**
  * @brief Calculate the embedding distance between tracks and detections and create a mask for the cost matrix
- *  when the embedding distance is greater than the threshold
+ *  when the embedding distance is greater than the threshold.
+ *  The L2-normalized track and detection features are stacked into contiguous matrices and compared with a single
+ *  matrix product. Pairs with a missing feature get a cost of 1 and are masked.
  * 
  * @param tracks Tracks used to create the cost matrix
  * @param detections Tracks created from detections used to create the cost matrix
  * @param max_embedding_distance Threshold for embedding distance
  * @param distance_metric Distance metric to use for calculating the embedding distance
+ * @param gallery_matching If true, the distance of a track is the minimum over its smoothed feature and its feature history,
+ *  otherwise only the smoothed feature is used
  * @return std::tuple<CostMatrix, CostMatrix> Tuple of embedding distance cost matrix and embedding distance mask
  */
 std::tuple<CostMatrix, CostMatrix>
 embedding_distance(const std::vector<std::shared_ptr<Track>> &tracks,
                    const std::vector<std::shared_ptr<Track>> &detections,
-                   float max_embedding_distance,
-                   const std::string &distance_metric);
+                   float max_embedding_distance, DistanceMetric distance_metric,
+                   bool gallery_matching = false);
 
 /**
- * @brief Fuses the detection score into the cost matrix in-place
- *     fused_cost = 1 - ((1 - cost_matrix) * detection_score)
- *     fused_cost = 1 - (similarity * detection_score)
+ * @brief Build the final association cost matrix between tracks and detections in a single fused pass.
+ *  Every tile of (track, detection) pairs is computed in one go. The cost of a pair is the minimum of
+ *  - the IoU distance fused with the detection score, 1 - IoU * score,
+ *  - the embedding distance (one matrix product per tile) fused with the motion gating distance,
+ *    lambda * embedding + (1 - lambda) * gating, infinite outside the chi-square gate. It is 1 when the pair is
+ *    outside the IoU threshold, beyond the embedding threshold or has no features.
+ *  Only the final cost matrix is written.
  * 
- * @param cost_matrix Cost matrix in which to fuse the detection score
+ * @param tracks Tracks used to create the cost matrix, gated with their own motion model
  * @param detections Tracks created from detections used to create the cost matrix
+ * @param max_iou_distance Threshold for IoU distance
+ * @param use_embedding If false, the cost is the masked score fused IoU distance only
+ * @param max_embedding_distance Threshold for embedding distance
+ * @param distance_metric Distance metric to use for calculating the embedding distance
+ * @param lambda Weighting factor for motion
+ * @param gallery_matching If true, the embedding distance of a track is the minimum over its smoothed feature and its feature history
+ * @return CostMatrix Fused and masked cost matrix
  */
-void fuse_score(CostMatrix &cost_matrix,
-                const std::vector<std::shared_ptr<Track>> &detections);
+CostMatrix fused_association_distance(
+        const std::vector<std::shared_ptr<Track>> &tracks,
+        const std::vector<std::shared_ptr<Track>> &detections,
+        float max_iou_distance, bool use_embedding,
+        float max_embedding_distance, DistanceMetric distance_metric,
+        float lambda, bool gallery_matching = false);
 
 /**
- * @brief Fuses motion (maha distance) into the cost matrix in-place
- *      fused_cost = lambda * cost_matrix + (1 - lambda) * motion_distance
- * @param KF Kalman filter
- * @param cost_matrix Cost matrix in which to fuse motion
- * @param tracks Tracks used to create the cost matrix
- * @param detections Tracks created from detections used to create the cost matrix
- * @param lambda Weighting factor for motion (default: 0.98)
- * @param only_position Set to true only position should be used for gating distance
+ * @brief Solver used by linear_assignment
+ *
+ * AssignmentSolver solver: Solver backend
+ * float auction_epsilon: Optimality tolerance of the auction solver
+ * float time_budget_us: Time budget of a linear_assignment call with the Budgeted solver, in microseconds
  */
-void fuse_motion(const KalmanFilter &KF, CostMatrix &cost_matrix,
-                 const std::vector<std::shared_ptr<Track>> &tracks,
-                 const std::vector<std::shared_ptr<Track>> &detections,
-                 float lambda = 0.98F, bool only_position = false);
+struct AssignmentOptions
+{
+    AssignmentSolver solver = AssignmentSolver::LAPJV;
+    float auction_epsilon = 1e-4f;
+    float time_budget_us = 1000.0f;
+};
 
 /**
- * @brief Fuse IoU distance with embedding distance keeping the mask in mind
- * 
- * @param iou_dist Score fused IoU distance cost matrix
- * @param emb_dist Motion fused embedding distance cost matrix
- * @param iou_dists_mask IoU distance mask
- * @param emb_dists_mask Embedding distance mask
- * @return CostMatrix Fused and masked cost matrix
+ * @brief Memory reused by linear_assignment across frames, one solver slot per component solved concurrently
  */
-CostMatrix fuse_iou_with_emb(CostMatrix &iou_dist, CostMatrix &emb_dist,
-                             const CostMatrix &iou_dists_mask,
-                             const CostMatrix &emb_dists_mask);
+struct AssignmentWorkspace
+{
+    struct Solver
+    {
+        CostMatrix component_cost;
+        std::vector<int> rowsol, colsol;
+        LapjvWorkspace lapjv;
+        SolveTimeModel time_model;
+        AssignmentDuals duals;
+    };
+
+    std::vector<Solver> solvers;
+};
 
 /**
- * @brief Performs linear assignment using the LAPJV algorithm
+ * @brief Performs linear assignment using the LAPJV algorithm.
+ *  Pairs with a cost above the threshold are never matched, so the problem is first split into the connected components
+ *  of the feasible-pair graph. Components with a single track or a single detection are solved directly, the others are
+ *  solved as independent LAPs, in parallel when a thread pool is given. With the auction solver, the components are
+ *  solved one after another and the thread pool is used for the bids of each auction instead.
+ *  With the Budgeted solver, a component is matched greedily instead when the time already spent in the call plus the
+ *  predicted duration of its exact solve exceeds the time budget.
+ *  With duals, the exact solves start from the seeded pairs and the duals of the previous solve (see LsapWarmStart),
+ *  so only the rows whose seed no longer holds are augmented.
  * 
  * @param cost_matrix Cost matrix for solving the linear assignment problem
  * @param thresh Threshold for cost matrix
+ * @param thread_pool (Optional) Thread pool on which to solve the components
+ * @param workspace (Optional) Solver memory kept across calls, a temporary one is used if not given
+ * @param options (Optional) Solver used for the components, LAPJV by default
+ * @param duals (Optional) Warm start of the exact solvers, replaced by the duals of the solution
  * @return AssociationData Association data
  */
-AssociationData linear_assignment(CostMatrix &cost_matrix, float thresh);
+AssociationData linear_assignment(CostMatrix &cost_matrix, float thresh,
+                                  ThreadPool *thread_pool = nullptr,
+                                  AssignmentWorkspace *workspace = nullptr,
+                                  const AssignmentOptions &options = {},
+                                  AssignmentDuals *duals = nullptr);
+
+/**
+ * @brief Keeps the duals of an association stage from one frame to the next, keyed by track id.
+ *  The detection a track was matched to is remembered with the duals: in the next frame, the track is seeded with
+ *  the detection overlapping it the most, which inherits the dual of the previous detection.
+ */
+class AssociationWarmStart
+{
+public:
+    /**
+     * @brief Seeds and duals of the association of the current frame, from the matches of the previous one
+     * 
+     * @param tracks Tracks of the association (rows)
+     * @param detections Detections of the association (columns)
+     * @return AssignmentDuals* Warm start to give to linear_assignment
+     */
+    AssignmentDuals *seed(const std::vector<std::shared_ptr<Track>> &tracks,
+                          const std::vector<std::shared_ptr<Track>> &detections);
+
+    /**
+     * @brief Remember the duals of the matches, once linear_assignment solved the association seeded by seed()
+     * 
+     * @param tracks Tracks of the association (rows)
+     * @param detections Detections of the association (columns)
+     * @param associations Result of linear_assignment
+     */
+    void update(const std::vector<std::shared_ptr<Track>> &tracks,
+                const std::vector<std::shared_ptr<Track>> &detections,
+                const AssociationData &associations);
+
+private:
+    // Minimum IoU between a detection and the previous detection of a track to seed the track with it
+    static constexpr float min_seed_iou = 0.5F;
+
+    struct Entry
+    {
+        BBox detection_tlwh;
+        float track_dual, detection_dual;
+    };
+
+    std::unordered_map<int, Entry> _entries;
+    AssignmentDuals _duals;
+    std::vector<bool> _seeded_detections;
+};
 }
@@ -1,16 +1,14 @@
 #pragma once
 
-#include <deque>
 #include <memory>
+#include <utility>
 
-#include "KalmanFilter.h"
-#include "KalmanFilterAccBased.h"
+#include "EmbeddingArena.h"
+#include "MotionModel.h"
 
 namespace botsort
 {
 
-using KalmanFilter = bot_kalman::KalmanFilter;
-
 enum TrackState
 {
     New = 0,
@@ -30,11 +28,11 @@ public:
      * @param score Detection score
      * @param class_id Detection class ID
      * @param feat (Optional) Detection feature vector
-     * @param feat_history_size Size of the feature history (default: 50)
+     * @param embedding_arena (Optional) Arena providing the feature history of the track once it is activated
      */
-    Track(std::vector<float> tlwh, float score, uint8_t class_id,
+    Track(const BBox &tlwh, float score, uint8_t class_id,
           std::optional<FeatureVector> feat = std::nullopt,
-          int feat_history_size = 50);
+          std::shared_ptr<EmbeddingArena> embedding_arena = nullptr);
 
     /**
      * @brief Get the next track ID
@@ -50,6 +48,13 @@ public:
      */
     uint32_t end_frame() const;
 
+    /**
+     * @brief Get the frame-id of the last visual feature fused into the track
+     * 
+     * @return uint32_t Frame-id of the last feature, 0 if the track has none
+     */
+    uint32_t feature_frame() const;
+
     /**
      * @brief Upates the track state to Lost
      * 
@@ -71,7 +76,7 @@ public:
     /**
      * @brief Get the latest detection bounding box in the format [top-left-x, top-left-y, width, height]
      */
-    std::vector<float> get_tlwh() const;
+    const BBox &get_tlwh() const;
 
     /**
      * @brief Get the score object
@@ -80,50 +85,60 @@ public:
      */
     float get_score() const;
 
+    /**
+     * @brief Get the class ID of the track
+     * 
+     * @return uint8_t Most likely class ID given the class history of the track
+     */
+    uint8_t get_class_id() const;
+
     /**
      * @brief Activates the track
      * 
-     * @param kalman_filter Kalman filter object for the track
+     * @param motion_model Motion model of the track, used for all its predictions and updates
      * @param frame_id Current frame-id
+     * @param recovered_id (Optional) Track ID of a previously removed track re-identified for this detection.
+     *  The track then keeps that ID and is confirmed immediately
      */
-    void activate(KalmanFilter &kalman_filter, uint32_t frame_id);
+    void activate(std::shared_ptr<const MotionModel> motion_model,
+                  uint32_t frame_id,
+                  std::optional<int> recovered_id = std::nullopt);
 
     /**
      * @brief Re-activates the track
      * 
-     * @param kalman_filter Kalman filter object
      * @param new_track New track object
      * @param frame_id Current frame-id
      * @param new_id Whether to assign a new ID to the track (default: false)
      */
-    void re_activate(KalmanFilter &kalman_filter, Track &new_track,
-                     uint32_t frame_id, bool new_id = false);
+    void re_activate(Track &new_track, uint32_t frame_id, bool new_id = false);
 
     /**
-     * @brief Predict the next state of the track using the Kalman filter
-     * 
-     * @param kalman_filter Kalman filter class object
+     * @brief Predict the next state of the track using its motion model
      */
-    void predict(KalmanFilter &kalman_filter);
+    void predict();
 
     /**
-     * @brief Predict the next state of multiple tracks using the Kalman filter
+     * @brief Predict the state of a track that is not tracked up to the given frame, in closed form over all the
+     *  frames elapsed since its state was last predicted or updated
      * 
-     * @param tracks Tracks on which to perform the prediction step
-     * @param kalman_filter Kalman filter object for the tracks
+     * @param frame_id Frame-id to predict the state for
      */
-    void static multi_predict(std::vector<std::shared_ptr<Track>> &tracks,
-                              KalmanFilter &kalman_filter);
+    void predict_to(uint32_t frame_id);
 
     /**
-     * @brief Apply camera motion to the track
+     * @brief Predict the next state of multiple tracks using their motion models.
+     *  Tracks are predicted one by one: a batched structure-of-arrays filter was measured slower end to end
+     *  than a per-track step exploiting the block structure of F and H, as gathering and scattering the
+     *  states cost more than the batched kernels saved.
      * 
-     * @param H Homography matrix
+     * @param tracks Tracks on which to perform the prediction step
      */
-    void apply_camera_motion(const HomographyMatrix &H);
+    void static multi_predict(std::vector<std::shared_ptr<Track>> &tracks);
 
     /**
-     * @brief Apply camera motion to multiple tracks
+     * @brief Apply camera motion to multiple tracks. The rotation and translation are extracted once, then each
+     *  track only transforms the 2x2 blocks of its state that change (see _apply_camera_motion)
      * 
      * @param tracks Tracks on which to apply the camera motion
      * @param H Homography matrix
@@ -137,8 +152,43 @@ public:
      * @param new_track New track object to be used to update the old track
      * @param frame_id Current frame-id
      */
-    void update(KalmanFilter &kalman_filter, Track &new_track,
-                uint32_t frame_id);
+    void update(Track &new_track, uint32_t frame_id);
+
+    /**
+     * @brief Attach a visual feature vector to a track created without one,
+     *  used when features are extracted lazily after the track was created
+     * 
+     * @param feat Feature vector
+     */
+    void set_features(const FeatureVector &feat);
+
+    /**
+     * @brief Get the feature history of the track
+     * 
+     * @return const FeatureGallery* Feature history, nullptr if the track has none
+     */
+    const FeatureGallery *get_feature_history() const;
+
+    /**
+     * @brief Get the motion model of the track, set when the track is activated and when its class changes
+     * 
+     * @return const MotionModel& Motion model
+     */
+    const MotionModel &motion_model() const
+    {
+        return *_motion_model;
+    }
+
+    /**
+     * @brief Switch the track to another motion model, e.g. when its voted class changes.
+     *  All the motion models share the state layout, so the state carries over as is.
+     * 
+     * @param motion_model Motion model used from the next prediction on
+     */
+    void set_motion_model(std::shared_ptr<const MotionModel> motion_model)
+    {
+        _motion_model = std::move(motion_model);
+    }
 
 private:
     /**
@@ -149,14 +199,29 @@ private:
      */
     void _update_features(const std::shared_ptr<FeatureVector> &feat);
 
+    /**
+     * @brief Apply camera motion to the track state in place, block-wise: the center of the mean, the first two
+     *  rows and the first two columns of the covariance, with fixed-size products only
+     * 
+     * @param R Rotation and scale of the homography (top-left 2x2 block)
+     * @param t Translation of the homography
+     */
+    void _apply_camera_motion(const Eigen::Matrix2f &R, const Eigen::Vector2f &t);
+
+    /**
+     * @brief Add a feature vector to the feature history, taking a gallery from the embedding arena on first use
+     * 
+     * @param feat Feature vector
+     */
+    void _push_feature_history(const FeatureVector &feat);
+
     /**
      * @brief Populate a DetVec bbox object (xywh) from the detection bounding box (tlwh)
      * 
      * @param bbox_xywh DetVec bbox object (xywh) to be populated
      * @param tlwh Detection bounding box (tlwh)
      */
-    static void _populate_DetVec_xywh(DetVec &bbox_xywh,
-                                      const std::vector<float> &tlwh);
+    static void _populate_DetVec_xywh(DetVec &bbox_xywh, const BBox &tlwh);
 
     /**
      * @brief Update the tracklet bounding box (stored as tlwh) inplace according to the tracker state
@@ -185,20 +250,27 @@ public:
 
     uint32_t frame_id, tracklet_len, start_frame;
 
-    std::vector<float> det_tlwh;
+    BBox det_tlwh;
     std::shared_ptr<FeatureVector> curr_feat;
     std::unique_ptr<FeatureVector> smooth_feat;
     KFStateSpaceVec mean;
     KFStateSpaceMatrix covariance;
 
 private:
-    std::vector<float> _tlwh;
+    BBox _tlwh;
     std::vector<std::pair<uint8_t, float>> _class_hist;
     float _score;
     uint8_t _class_id;
     static constexpr float _alpha = 0.9;
 
-    int _feat_history_size;
-    std::deque<std::shared_ptr<FeatureVector>> _feat_history;
+    // Frame-id the Kalman filter state (mean, covariance) refers to
+    uint32_t _state_frame_id;
+
+    // Frame-id of the last visual feature fused into smooth_feat
+    uint32_t _feature_frame_id;
+
+    std::shared_ptr<const MotionModel> _motion_model;
+    std::shared_ptr<EmbeddingArena> _embedding_arena;
+    std::unique_ptr<FeatureGallery> _feat_history;
 };
 }
@@ -1,38 +1,16 @@
 #pragma once
 
+#include <vector>
+
 #include "DataType.h"
+#include "ThreadPool.h"
+#include "auction.h"
+#include "lapjv.h"
+#include "lsap.h"
 
 namespace botsort
 {
 
-/**
- * @brief Calculate the cosine distance between two feature vectors
- * 
- * @param x Feature vector 1
- * @param y Feature vector 2
- * @return float Cosine distance (1 - cosine similarity)
- */
-inline float cosine_distance(const std::unique_ptr<FeatureVector> &x,
-                             const std::shared_ptr<FeatureVector> &y)
-{
-    return 1.0f - (x->dot(*y) / (x->norm() * y->norm() + 1e-5f));
-}
-
-
-/**
- * @brief Calculate the euclidean distance between two feature vectors
- * 
- * @param x Feature vector 1
- * @param y Feature vector 2
- * @return float Euclidean distance
- */
-inline float euclidean_distance(const std::unique_ptr<FeatureVector> &x,
-                                const std::shared_ptr<FeatureVector> &y)
-{
-    return (x->transpose() - y->transpose()).norm();
-}
-
-
 /**
  * @brief Calculate the intersection over union (IoU) between two bounding boxes
  * 
@@ -40,8 +18,7 @@ inline float euclidean_distance(const std::unique_ptr<FeatureVector> &x,
  * @param tlwh_b Bounding box 2 in the format (top left x, top left y, width, height)
  * @return float IoU
  */
-inline float iou(const std::vector<float> &tlwh_a,
-                 const std::vector<float> &tlwh_b)
+inline float iou(const BBox &tlwh_a, const BBox &tlwh_b)
 {
     float left = std::max(tlwh_a[0], tlwh_b[0]);
     float top = std::max(tlwh_a[1], tlwh_b[1]);
@@ -54,7 +31,99 @@ inline float iou(const std::vector<float> &tlwh_a,
     return area_i / (area_a + area_b - area_i);
 }
 
-double lapjv(CostMatrix &cost, std::vector<int> &rowsol,
+/**
+ * @brief Persistent memory of the assignment solvers. The cost matrix is stored row-major in a flat aligned buffer,
+ *  and all the buffers only grow, so a solver reusing the same workspace frame after frame does not allocate
+ *  in steady state.
+ */
+struct LapjvWorkspace
+{
+    std::vector<float, Eigen::aligned_allocator<float>> cost;
+    std::vector<int_t> x, y, seeds;
+    LapjvBuffers<float> buffers;
+    LsapBuffers<float> lsap_buffers;
+    AuctionBuffers<float> auction_buffers;
+};
+
+/**
+ * @brief Dual variables of an assignment, kept to warm-start the solve of a similar problem (see LsapWarmStart),
+ *  typically the same association in the next frame
+ *
+ * std::vector<int> row_seeds: Column each row starts from, -1 if none. Set by the caller, ignored unless it has n_rows elements
+ * std::vector<float> row_duals, col_duals: Dual variables of the rows and columns, set by the solve
+ */
+struct AssignmentDuals
+{
+    std::vector<int> row_seeds;
+    std::vector<float> row_duals, col_duals;
+};
+
+/**
+ * @brief Solve a linear assignment problem. Square problems are solved with the LAPJV algorithm, problems where rows
+ *  and columns may be left unassigned (rectangular, or with a cost limit) with a rectangular shortest augmenting path
+ *  solver, without extending the cost matrix.
+ * 
+ * @param cost Cost matrix (n_rows x n_cols)
+ * @param rowsol Output column assigned to each row, -1 if the row is unassigned
+ * @param colsol Output row assigned to each column, -1 if the column is unassigned
+ * @param workspace Solver memory, reused across calls
+ * @param extend_cost Allow rows and columns to be left unassigned, required for rectangular matrices
+ * @param cost_limit If given, pairs above cost_limit are left unassigned (leaving a row or a column unassigned
+ *  costs cost_limit / 2)
+ * @param return_cost If true, compute the total cost of the assignment
+ * @param duals (Optional) Warm start of the solve, updated with the duals of the solution. The problem is then always
+ *  solved with the rectangular solver
+ * @return double Total cost of the assignment, 0 if return_cost is false
+ * @throws std::runtime_error If the matrix is rectangular without extend_cost, or if the solver fails
+ */
+double lapjv(const CostMatrix &cost, std::vector<int> &rowsol,
+             std::vector<int> &colsol, LapjvWorkspace &workspace,
+             bool extend_cost = false,
+             float cost_limit = std::numeric_limits<float>::max(),
+             bool return_cost = true, AssignmentDuals *duals = nullptr);
+
+/**
+ * @brief Solve a linear assignment problem with the epsilon-scaling auction algorithm, see lsap_auction.
+ *  Meant for very large problems, where the bids are computed in parallel on the thread pool.
+ * 
+ * @param cost Cost matrix (n_rows x n_cols)
+ * @param rowsol Output column assigned to each row, -1 if the row is unassigned
+ * @param colsol Output row assigned to each column, -1 if the column is unassigned
+ * @param workspace Solver memory, reused across calls
+ * @param cost_limit If given, pairs above cost_limit are left unassigned. Otherwise the smaller side is fully assigned
+ * @param epsilon Optimality tolerance, the total cost is within (n_rows + n_cols) * epsilon of the optimum
+ * @param thread_pool (Optional) Thread pool on which to compute the bids
+ * @param return_cost If true, compute the total cost of the assignment
+ * @return double Total cost of the assignment, 0 if return_cost is false
+ * @throws std::runtime_error If the solver fails
+ */
+double auction(const CostMatrix &cost, std::vector<int> &rowsol,
+               std::vector<int> &colsol, LapjvWorkspace &workspace,
+               float cost_limit = std::numeric_limits<float>::max(),
+               float epsilon = 1e-4f, ThreadPool *thread_pool = nullptr,
+               bool return_cost = true);
+
+/**
+ * @brief Match rows and columns greedily, cheapest pairs first, see lsap_greedy. Not optimal, but its cost only
+ *  depends on the number of feasible pairs.
+ * 
+ * @param cost Cost matrix (n_rows x n_cols)
+ * @param rowsol Output column assigned to each row, -1 if the row is unassigned
+ * @param colsol Output row assigned to each column, -1 if the column is unassigned
+ * @param workspace Solver memory, reused across calls
+ * @param cost_limit Pairs above cost_limit are never matched
+ * @param return_cost If true, compute the total cost of the assignment
+ * @return double Total cost of the assignment, 0 if return_cost is false
+ */
+double greedy(const CostMatrix &cost, std::vector<int> &rowsol,
+              std::vector<int> &colsol, LapjvWorkspace &workspace,
+              float cost_limit = std::numeric_limits<float>::max(),
+              bool return_cost = true);
+
+/**
+ * @brief Solve a linear assignment problem with the LAPJV algorithm, using a temporary workspace
+ */
+double lapjv(const CostMatrix &cost, std::vector<int> &rowsol,
              std::vector<int> &colsol, bool extend_cost = false,
              float cost_limit = std::numeric_limits<float>::max(),
              bool return_cost = true);
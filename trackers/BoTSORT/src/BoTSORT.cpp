@@ -1,5 +1,6 @@
 #include "BoTSORT.h"
 
+#include <chrono>
 #include <optional>
 #include <unordered_set>
 
@@ -26,15 +27,36 @@ BoTSORT::BoTSORT(const std::string &tracker_config_path,
     _frame_id = 0;
     _buffer_size = static_cast<uint8_t>(_frame_rate / 30.0 * _track_buffer);
     _max_time_lost = _buffer_size;
-    _kalman_filter = std::make_unique<KalmanFilter>(
-            static_cast<double>(1.0 / _frame_rate));
+
+    // One motion model per type in use, shared by the tracks
+    _motion_models[_motion_model_type] = MotionModel::create(
+            _motion_model_type, static_cast<double>(1.0 / _frame_rate),
+            _kalman_steady_state_after);
+    for (const auto &[class_id, type]: _class_motion_model_types)
+    {
+        if (_motion_models.find(type) == _motion_models.end())
+        {
+            _motion_models[type] = MotionModel::create(
+                    type, static_cast<double>(1.0 / _frame_rate),
+                    _kalman_steady_state_after);
+        }
+    }
 
 
     // Re-ID module, load visual feature extractor here
     if (_reid_enabled && reid_config_path.size() > 0 &&
         reid_onnx_model_path.size() > 0)
+    {
         _reid_model = std::make_unique<ReIDModel>(reid_config_path,
                                                   reid_onnx_model_path);
+        _embedding_arena =
+                std::make_shared<EmbeddingArena>(_feat_history_size);
+
+        if (_long_term_reid_enabled)
+            _identity_memory = std::make_unique<IdentityMemory>(
+                    _long_term_capacity, _ivf_lists, _ivf_probes,
+                    _long_term_max_age);
+    }
     else
     {
         std::cout << "Re-ID module disabled" << std::endl;
@@ -52,6 +74,16 @@ BoTSORT::BoTSORT(const std::string &tracker_config_path,
         std::cout << "GMC disabled" << std::endl;
         _gmc_enabled = false;
     }
+
+
+    // Worker threads for overlapping ReID, GMC and KF prediction within a frame, and for the auction bids
+    if (_num_worker_threads > 0 &&
+        (_reid_enabled || _gmc_enabled ||
+         _first_assignment_options.solver == AssignmentSolver::Auction ||
+         _second_assignment_options.solver == AssignmentSolver::Auction ||
+         _long_lost_assignment_options.solver == AssignmentSolver::Auction ||
+         _unconfirmed_assignment_options.solver == AssignmentSolver::Auction))
+        _thread_pool = std::make_unique<ThreadPool>(_num_worker_threads);
 }
 
 
@@ -59,8 +91,8 @@ std::vector<std::shared_ptr<Track>>
 BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
 {
     PROFILE_FUNCTION();
-    ////////////////// CREATE TRACK OBJECT FOR ALL THE DETECTIONS //////////////////
-    // For all detections, extract features, create tracks and classify on the segregate of confidence
+    ////////////////// Gather the detections kept for tracking //////////////////
+    // Clip all the detections to the frame, and keep the ones above the low confidence threshold
     _frame_id++;
     std::vector<std::shared_ptr<Track>> activated_tracks, refind_tracks;
     std::vector<std::shared_ptr<Track>> detections_high_conf,
@@ -68,47 +100,72 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
     detections_low_conf.reserve(detections.size()),
             detections_high_conf.reserve(detections.size());
 
-    if (!detections.empty())
+    for (Detection &detection: const_cast<std::vector<Detection> &>(detections))
     {
-        for (Detection &detection:
-             const_cast<std::vector<Detection> &>(detections))
+        detection.bbox_tlwh.x = std::max(0.0f, detection.bbox_tlwh.x);
+        detection.bbox_tlwh.y = std::max(0.0f, detection.bbox_tlwh.y);
+        detection.bbox_tlwh.width = std::min(static_cast<float>(frame.cols - 1),
+                                             detection.bbox_tlwh.width);
+        detection.bbox_tlwh.height =
+                std::min(static_cast<float>(frame.rows - 1),
+                         detection.bbox_tlwh.height);
+    }
+
+    // Gather all the detections that are kept for tracking, so that their
+    // visual features can be extracted in a single batched pass
+    std::vector<const Detection *> kept_detections;
+    std::vector<cv::Rect_<float>> kept_bboxes;
+    kept_detections.reserve(detections.size());
+    kept_bboxes.reserve(detections.size());
+    for (const Detection &detection: detections)
+    {
+        if (detection.confidence > _track_low_thresh)
         {
-            detection.bbox_tlwh.x = std::max(0.0f, detection.bbox_tlwh.x);
-            detection.bbox_tlwh.y = std::max(0.0f, detection.bbox_tlwh.y);
-            detection.bbox_tlwh.width =
-                    std::min(static_cast<float>(frame.cols - 1),
-                             detection.bbox_tlwh.width);
-            detection.bbox_tlwh.height =
-                    std::min(static_cast<float>(frame.rows - 1),
-                             detection.bbox_tlwh.height);
+            kept_detections.push_back(&detection);
+            kept_bboxes.push_back(detection.bbox_tlwh);
+        }
+    }
+    ////////////////// Gather the detections kept for tracking //////////////////
 
-            std::shared_ptr<Track> tracklet;
-            std::vector<float> tlwh = {
-                    detection.bbox_tlwh.x, detection.bbox_tlwh.y,
-                    detection.bbox_tlwh.width, detection.bbox_tlwh.height};
 
-            if (detection.confidence > _track_low_thresh)
-            {
-                if (_reid_enabled)
-                {
-                    FeatureVector embedding =
-                            _extract_features(frame, detection.bbox_tlwh);
-                    tracklet = std::make_shared<Track>(
-                            tlwh, detection.confidence, detection.class_id,
-                            embedding);
-                }
-                else
-                    tracklet = std::make_shared<Track>(
-                            tlwh, detection.confidence, detection.class_id);
+    ////////////////// ReID, KF predict and GMC, then create a track object for each detection //////////////////
+    // The three steps are independent of each other until association starts, so they run as a
+    // small task graph: ReID and GMC are scheduled on the thread pool while KF prediction runs on
+    // the calling thread. GMC warping of the tracks waits for both GMC and KF prediction.
+    std::future<FeatureMatrix> embeddings_task;
+    if (_reid_enabled && !_lazy_reid && !kept_bboxes.empty())
+    {
+        embeddings_task = _schedule(
+                [&]() { return _extract_features(frame, kept_bboxes); });
+    }
 
-                if (detection.confidence >= _track_high_thresh)
-                    detections_high_conf.push_back(tracklet);
-                else
-                    detections_low_conf.push_back(tracklet);
-            }
-        }
+    std::future<HomographyMatrix> homography_task;
+    if (_gmc_enabled)
+    {
+        homography_task =
+                _schedule([&]() { return _gmc_algo->apply(frame, detections); });
     }
 
+    // The tasks reference the frame, the detections and kept_bboxes. If anything throws before their
+    // results are collected, wait for the running ones so they never outlive these references
+    struct PendingTasks
+    {
+        std::future<FeatureMatrix> &embeddings;
+        std::future<HomographyMatrix> &homography;
+
+        ~PendingTasks()
+        {
+            if (embeddings.valid() &&
+                embeddings.wait_for(std::chrono::seconds(0)) !=
+                        std::future_status::deferred)
+                embeddings.wait();
+            if (homography.valid() &&
+                homography.wait_for(std::chrono::seconds(0)) !=
+                        std::future_status::deferred)
+                homography.wait();
+        }
+    } pending_tasks{embeddings_task, homography_task};
+
     // Segregate tracks in unconfirmed and tracked tracks
     std::vector<std::shared_ptr<Track>> unconfirmed_tracks, tracked_tracks;
     for (const std::shared_ptr<Track> &track: _tracked_tracks)
@@ -122,58 +179,105 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
             tracked_tracks.push_back(track);
         }
     }
-    ////////////////// CREATE TRACK OBJECT FOR ALL THE DETECTIONS //////////////////
 
-
-    ////////////////// Apply KF predict and GMC before running association algorithm //////////////////
     // Merge currently tracked tracks and lost tracks
     std::vector<std::shared_ptr<Track>> tracks_pool;
     tracks_pool = _merge_track_lists(tracked_tracks, _lost_tracks);
 
     // Predict the location of the tracks with KF (even for lost tracks)
-    Track::multi_predict(tracks_pool, *_kalman_filter);
+    Track::multi_predict(tracks_pool);
 
-    // Estimate camera motion and apply camera motion compensation
+    // Apply camera motion compensation once the camera motion has been estimated
     if (_gmc_enabled)
     {
-        HomographyMatrix H = _gmc_algo->apply(frame, detections);
+        HomographyMatrix H = homography_task.get();
         Track::multi_gmc(tracks_pool, H);
         Track::multi_gmc(unconfirmed_tracks, H);
+
+        // Long lost tracks are not predicted, but their frozen centers still follow the camera. GMC only moves the
+        // center, so warping it every frame and predicting over the elapsed frames on recovery matches warping
+        // each per-frame prediction exactly for translations and closely for slow rotations
+        Track::multi_gmc(_long_lost_tracks, H);
     }
-    ////////////////// Apply KF predict and GMC before running association algorithm //////////////////
 
+    // Create tracks for the detections once their visual features are available
+    FeatureMatrix embeddings;
+    if (embeddings_task.valid())
+    {
+        embeddings = embeddings_task.get();
+    }
 
-    ////////////////// ASSOCIATION ALGORITHM STARTS HERE //////////////////
-    ////////////////// First association, with high score detection boxes //////////////////
-    // Find IoU distance between all tracked tracks and high confidence detections
-    CostMatrix iou_dists, raw_emd_dist, iou_dists_mask_1st_association,
-            emd_dist_mask_1st_association;
+    for (size_t i = 0; i < kept_detections.size(); i++)
+    {
+        const Detection &detection = *kept_detections[i];
+        BBox tlwh = {detection.bbox_tlwh.x, detection.bbox_tlwh.y,
+                     detection.bbox_tlwh.width, detection.bbox_tlwh.height};
 
-    std::tie(iou_dists, iou_dists_mask_1st_association) =
-            iou_distance(tracks_pool, detections_high_conf, _proximity_thresh);
-    fuse_score(iou_dists,
-               detections_high_conf);// Fuse the score with IoU distance
+        std::shared_ptr<Track> tracklet;
+        if (_reid_enabled && !_lazy_reid)
+        {
+            tracklet = std::make_shared<Track>(
+                    tlwh, detection.confidence, detection.class_id,
+                    FeatureVector(embeddings.row(static_cast<Eigen::Index>(i))),
+                    _embedding_arena);
+        }
+        else
+            tracklet = std::make_shared<Track>(tlwh, detection.confidence,
+                                               detection.class_id, std::nullopt,
+                                               _embedding_arena);
 
-    if (_reid_enabled)
-    {
-        // If re-ID is enabled, find the embedding distance between all tracked tracks and high confidence detections
-        std::tie(raw_emd_dist, emd_dist_mask_1st_association) =
-                embedding_distance(tracks_pool, detections_high_conf,
-                                   _appearance_thresh,
-                                   _reid_model->get_distance_metric());
-        fuse_motion(*_kalman_filter, raw_emd_dist, tracks_pool,
-                    detections_high_conf,
-                    _lambda);// Fuse the motion with embedding distance
+        if (detection.confidence >= _track_high_thresh)
+            detections_high_conf.push_back(tracklet);
+        else
+            detections_low_conf.push_back(tracklet);
     }
+    ////////////////// ReID, KF predict and GMC, then create a track object for each detection //////////////////
 
-    // Fuse the IoU distance and embedding distance to get the final distance matrix
-    CostMatrix distances_first_association = fuse_iou_with_emb(
-            iou_dists, raw_emd_dist, iou_dists_mask_1st_association,
-            emd_dist_mask_1st_association);
 
-    // Perform linear assignment on the final distance matrix, LAPJV algorithm is used here
-    AssociationData first_associations =
-            linear_assignment(distances_first_association, _match_thresh);
+    ////////////////// ASSOCIATION ALGORITHM STARTS HERE //////////////////
+    ////////////////// First association, with high score detection boxes //////////////////
+    if (_reid_enabled && _lazy_reid)
+    {
+        // With lazy ReID, run the IoU gate first (against the unconfirmed tracks as well) and
+        // extract visual features only for the detections that IoU alone cannot resolve
+        std::vector<std::shared_ptr<Track>> gated_tracks = tracks_pool;
+        gated_tracks.insert(gated_tracks.end(), unconfirmed_tracks.begin(),
+                            unconfirmed_tracks.end());
+
+        CostMatrix gated_iou_dists, gated_iou_dists_mask;
+        std::tie(gated_iou_dists, gated_iou_dists_mask) = iou_distance(
+                gated_tracks, detections_high_conf, _proximity_thresh);
+
+        std::vector<std::shared_ptr<Track>> ambiguous_detections;
+        for (int detection_idx: _select_ambiguous_detections(
+                     gated_iou_dists_mask, gated_tracks))
+        {
+            ambiguous_detections.push_back(
+                    detections_high_conf[detection_idx]);
+        }
+        _extract_missing_features(frame, ambiguous_detections);
+    }
+
+    // Find the fused IoU, embedding and motion distance between all tracked tracks and high confidence detections
+    CostMatrix distances_first_association =
+            _association_distance(tracks_pool, detections_high_conf);
+
+    // Perform linear assignment on the final distance matrix, LAPJV algorithm is used here.
+    // It starts from the matches and duals of the previous frame when warm start is enabled
+    AssignmentDuals *first_association_duals =
+            _assignment_warm_start
+                    ? _first_association_warm_start.seed(tracks_pool,
+                                                         detections_high_conf)
+                    : nullptr;
+    AssociationData first_associations = linear_assignment(
+            distances_first_association, _match_thresh, _thread_pool.get(),
+            &_assignment_workspace, _first_assignment_options,
+            first_association_duals);
+    if (_assignment_warm_start)
+    {
+        _first_association_warm_start.update(tracks_pool, detections_high_conf,
+                                             first_associations);
+    }
 
     // Update the tracks with the associated detections
     for (const std::pair<int, int> &match: first_associations.matches)
@@ -185,14 +289,14 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
         // If track was being actively tracked, we update the track with the new associated detection
         if (track->state == TrackState::Tracked)
         {
-            track->update(*_kalman_filter, *detection, _frame_id);
+            track->update(*detection, _frame_id);
             activated_tracks.push_back(track);
         }
         else
         {
             // If track was not being actively tracked, we re-activate the track with the new associated detection
             // NOTE: There should be a minimum number of frames before a track is re-activated
-            track->re_activate(*_kalman_filter, *detection, _frame_id, false);
+            track->re_activate(*detection, _frame_id, false);
             refind_tracks.push_back(track);
         }
     }
@@ -218,7 +322,9 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
 
     // Perform linear assignment on the distance matrix, LAPJV algorithm is used here
     AssociationData second_associations =
-            linear_assignment(iou_dists_second, 0.5);
+            linear_assignment(iou_dists_second, 0.5, _thread_pool.get(),
+                              &_assignment_workspace,
+                              _second_assignment_options);
 
     // Update the tracks with the associated detections
     for (const std::pair<int, int> &match: second_associations.matches)
@@ -231,14 +337,14 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
         // If track was being actively tracked, we update the track with the new associated detection
         if (track->state == TrackState::Tracked)
         {
-            track->update(*_kalman_filter, *detection, _frame_id);
+            track->update(*detection, _frame_id);
             activated_tracks.push_back(track);
         }
         else
         {
             // If track was not being actively tracked, we re-activate the track with the new associated detection
             // NOTE: There should be a minimum number of frames before a track is re-activated
-            track->re_activate(*_kalman_filter, *detection, _frame_id, false);
+            track->re_activate(*detection, _frame_id, false);
             refind_tracks.push_back(track);
         }
     }
@@ -258,7 +364,7 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
     ////////////////// Second association, with low score detection boxes //////////////////
 
 
-    ////////////////// Deal with unconfirmed tracks //////////////////
+    ////////////////// High score detections left after the first association //////////////////
     std::vector<std::shared_ptr<Track>>
             unmatched_detections_after_1st_association;
     for (int detection_idx: first_associations.unmatched_det_indices)
@@ -267,38 +373,72 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
                 detections_high_conf[detection_idx];
         unmatched_detections_after_1st_association.push_back(detection);
     }
+    ////////////////// High score detections left after the first association //////////////////
 
-    //Find IoU distance between unconfirmed tracks and high confidence detections left after the first association
-    CostMatrix iou_dists_unconfirmed, raw_emd_dist_unconfirmed,
-            iou_dists_mask_unconfirmed, emd_dist_mask_unconfirmed;
 
-    std::tie(iou_dists_unconfirmed, iou_dists_mask_unconfirmed) = iou_distance(
-            unconfirmed_tracks, unmatched_detections_after_1st_association,
-            _proximity_thresh);
-    fuse_score(iou_dists_unconfirmed,
-               unmatched_detections_after_1st_association);
-
-    if (_reid_enabled)
+    ////////////////// Recover long lost tracks //////////////////
+    // Long lost tracks are neither predicted nor IoU-scored every frame (only motion compensated), they can only be
+    // recovered by appearance with the high confidence detections left after the first association. A recovered
+    // track is then predicted in closed form over all the frames elapsed since it was demoted, before being
+    // re-activated.
+    if (!_long_lost_tracks.empty() &&
+        !unmatched_detections_after_1st_association.empty())
     {
-        // Find embedding distance between unconfirmed tracks and high confidence detections left after the first association
-        std::tie(raw_emd_dist_unconfirmed, emd_dist_mask_unconfirmed) =
-                embedding_distance(unconfirmed_tracks,
+        if (_lazy_reid)
+        {
+            _extract_missing_features(
+                    frame, unmatched_detections_after_1st_association);
+        }
+
+        CostMatrix emb_dists_long_lost, emb_dists_mask_long_lost;
+        std::tie(emb_dists_long_lost, emb_dists_mask_long_lost) =
+                embedding_distance(_long_lost_tracks,
                                    unmatched_detections_after_1st_association,
                                    _appearance_thresh,
-                                   _reid_model->get_distance_metric());
-        fuse_motion(*_kalman_filter, raw_emd_dist_unconfirmed,
-                    unconfirmed_tracks,
-                    unmatched_detections_after_1st_association, _lambda);
+                                   _reid_model->get_distance_metric(),
+                                   _gallery_matching);
+
+        // Pairs beyond the appearance threshold (or without features) are above the cost limit
+        AssociationData long_lost_associations = linear_assignment(
+                emb_dists_long_lost, _appearance_thresh, _thread_pool.get(),
+                &_assignment_workspace, _long_lost_assignment_options);
+
+        for (const std::pair<int, int> &match:
+             long_lost_associations.matches)
+        {
+            const std::shared_ptr<Track> &track =
+                    _long_lost_tracks[match.first];
+            const std::shared_ptr<Track> &detection =
+                    unmatched_detections_after_1st_association[match.second];
+
+            track->predict_to(_frame_id);
+            track->re_activate(*detection, _frame_id, false);
+            refind_tracks.push_back(track);
+        }
+
+        std::vector<std::shared_ptr<Track>> unmatched_detections_after_recovery;
+        for (int detection_idx: long_lost_associations.unmatched_det_indices)
+        {
+            unmatched_detections_after_recovery.push_back(
+                    unmatched_detections_after_1st_association[detection_idx]);
+        }
+        unmatched_detections_after_1st_association =
+                std::move(unmatched_detections_after_recovery);
     }
+    ////////////////// Recover long lost tracks //////////////////
+
 
-    // Fuse the IoU distance and the embedding distance
-    CostMatrix distances_unconfirmed = fuse_iou_with_emb(
-            iou_dists_unconfirmed, raw_emd_dist_unconfirmed,
-            iou_dists_mask_unconfirmed, emd_dist_mask_unconfirmed);
+    ////////////////// Deal with unconfirmed tracks //////////////////
+    // Find the fused IoU, embedding and motion distance between unconfirmed tracks and high confidence detections
+    // left after the first association
+    CostMatrix distances_unconfirmed = _association_distance(
+            unconfirmed_tracks, unmatched_detections_after_1st_association);
 
     // Perform linear assignment on the distance matrix, LAPJV algorithm is used here
     AssociationData unconfirmed_associations =
-            linear_assignment(distances_unconfirmed, 0.7);
+            linear_assignment(distances_unconfirmed, 0.7, _thread_pool.get(),
+                              &_assignment_workspace,
+                              _unconfirmed_assignment_options);
 
     for (const std::pair<int, int> &match: unconfirmed_associations.matches)
     {
@@ -308,7 +448,7 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
 
         // If the unconfirmed track is associated with a detection we update the track with the new associated detection
         // and add the track to the activated tracks list
-        track->update(*_kalman_filter, *detection, _frame_id);
+        track->update(*detection, _frame_id);
         activated_tracks.push_back(track);
     }
 
@@ -325,6 +465,21 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
     ////////////////// Deal with unconfirmed tracks //////////////////
 
 
+    // The class of a track is voted over its detections: the tracks updated in this frame follow the motion
+    // model of their current class, in case the vote changed it
+    if (!_class_motion_model_types.empty())
+    {
+        for (const auto *updated_tracks: {&activated_tracks, &refind_tracks})
+        {
+            for (const std::shared_ptr<Track> &track: *updated_tracks)
+            {
+                track->set_motion_model(
+                        _motion_model_for(track->get_class_id()));
+            }
+        }
+    }
+
+
     ////////////////// Initialize new tracks //////////////////
     std::vector<std::shared_ptr<Track>> unmatched_high_conf_detections;
     for (int detection_idx: unconfirmed_associations.unmatched_det_indices)
@@ -334,13 +489,49 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
         unmatched_high_conf_detections.push_back(detection);
     }
 
-    // Initialize new tracks for the high confidence detections left after all the associations
+    // With lazy ReID, the detections starting new tracks still need visual features for later associations
+    if (_reid_enabled && _lazy_reid)
+    {
+        std::vector<std::shared_ptr<Track>> new_track_detections;
+        for (const std::shared_ptr<Track> &detection:
+             unmatched_high_conf_detections)
+        {
+            if (detection->get_score() >= _new_track_thresh)
+            {
+                new_track_detections.push_back(detection);
+            }
+        }
+        _extract_missing_features(frame, new_track_detections);
+    }
+
+    // Initialize new tracks for the high confidence detections left after all the associations.
+    // With long-term ReID, a detection matching the identity of a removed track takes over its track ID
+    if (_identity_memory)
+    {
+        _identity_memory->evict_expired(_frame_id);
+    }
+
     for (const std::shared_ptr<Track> &detection:
          unmatched_high_conf_detections)
     {
         if (detection->get_score() >= _new_track_thresh)
         {
-            detection->activate(*_kalman_filter, _frame_id);
+            std::optional<int> recovered_id;
+            if (_identity_memory && detection->curr_feat)
+            {
+                std::optional<IdentityMemory::Match> match =
+                        _identity_memory->query(*detection->curr_feat,
+                                                detection->get_class_id(),
+                                                _long_term_thresh);
+                if (match)
+                {
+                    recovered_id = match->track_id;
+                }
+            }
+
+            detection->activate(
+                    _motion_model_for(detection->get_class_id()), _frame_id,
+                    recovered_id);
             activated_tracks.push_back(detection);
         }
     }
@@ -348,12 +539,40 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
 
 
     ////////////////// Update lost tracks state //////////////////
+    auto remove_expired_track = [&](const std::shared_ptr<Track> &track) {
+        track->mark_removed();
+        removed_tracks.push_back(track);
+
+        // Remember the identity of the removed track for long-term re-identification
+        if (_identity_memory && track->smooth_feat)
+        {
+            _identity_memory->insert(track->track_id, track->get_class_id(),
+                                     *track->smooth_feat, track->end_frame());
+        }
+    };
+
+    // Tracks lost for more than long_lost_thresh frames are demoted to the long lost tier,
+    // which is only searched by appearance, so it requires ReID
+    std::vector<std::shared_ptr<Track>> long_lost_tracks;
     for (const std::shared_ptr<Track> &track: _lost_tracks)
     {
         if (_frame_id - track->end_frame() > _max_time_lost)
         {
-            track->mark_removed();
-            removed_tracks.push_back(track);
+            remove_expired_track(track);
+        }
+        else if (_reid_enabled && _long_lost_thresh > 0 &&
+                 _frame_id - track->end_frame() > _long_lost_thresh)
+        {
+            track->mark_long_lost();
+            long_lost_tracks.push_back(track);
+        }
+    }
+
+    for (const std::shared_ptr<Track> &track: _long_lost_tracks)
+    {
+        if (_frame_id - track->end_frame() > _max_time_lost)
+        {
+            remove_expired_track(track);
         }
     }
     ////////////////// Update lost tracks state //////////////////
@@ -375,6 +594,11 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
     _lost_tracks = _merge_track_lists(_lost_tracks, lost_tracks);
     _lost_tracks = _remove_from_list(_lost_tracks, _tracked_tracks);
     _lost_tracks = _remove_from_list(_lost_tracks, removed_tracks);
+    _lost_tracks = _remove_from_list(_lost_tracks, long_lost_tracks);
+
+    _long_lost_tracks = _merge_track_lists(_long_lost_tracks, long_lost_tracks);
+    _long_lost_tracks = _remove_from_list(_long_lost_tracks, _tracked_tracks);
+    _long_lost_tracks = _remove_from_list(_long_lost_tracks, removed_tracks);
 
     std::vector<std::shared_ptr<Track>> tracked_tracks_cleaned,
             lost_tracks_cleaned;
@@ -400,11 +624,104 @@ BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame)
 }
 
 
-FeatureVector BoTSORT::_extract_features(const cv::Mat &frame,
-                                         const cv::Rect_<float> &bbox_tlwh)
+CostMatrix BoTSORT::_association_distance(
+        const std::vector<std::shared_ptr<Track>> &tracks,
+        const std::vector<std::shared_ptr<Track>> &detections) const
+{
+    PROFILE_FUNCTION();
+    const DistanceMetric distance_metric =
+            _reid_enabled ? _reid_model->get_distance_metric()
+                          : DistanceMetric::Cosine;
+    return fused_association_distance(tracks, detections, _proximity_thresh,
+                                      _reid_enabled, _appearance_thresh,
+                                      distance_metric, _lambda,
+                                      _gallery_matching);
+}
+
+
+std::shared_ptr<const MotionModel>
+BoTSORT::_motion_model_for(uint8_t class_id) const
 {
-    cv::Mat patch = frame(bbox_tlwh);
-    return _reid_model->extract_features(patch);
+    auto it = _class_motion_model_types.find(class_id);
+    return _motion_models.at(it != _class_motion_model_types.end()
+                                     ? it->second
+                                     : _motion_model_type);
+}
+
+
+FeatureMatrix
+BoTSORT::_extract_features(const cv::Mat &frame,
+                           const std::vector<cv::Rect_<float>> &bboxes_tlwh)
+{
+    PROFILE_FUNCTION();
+    return _reid_model->extract_features(frame, bboxes_tlwh);
+}
+
+
+void BoTSORT::_extract_missing_features(
+        const cv::Mat &frame,
+        const std::vector<std::shared_ptr<Track>> &detections)
+{
+    std::vector<std::shared_ptr<Track>> pending_detections;
+    std::vector<cv::Rect_<float>> pending_bboxes;
+    for (const std::shared_ptr<Track> &detection: detections)
+    {
+        if (!detection->curr_feat)
+        {
+            const BBox &tlwh = detection->get_tlwh();
+            pending_detections.push_back(detection);
+            pending_bboxes.emplace_back(tlwh[0], tlwh[1], tlwh[2], tlwh[3]);
+        }
+    }
+
+    if (pending_detections.empty())
+    {
+        return;
+    }
+
+    FeatureMatrix embeddings = _extract_features(frame, pending_bboxes);
+    for (size_t i = 0; i < pending_detections.size(); i++)
+    {
+        pending_detections[i]->set_features(
+                embeddings.row(static_cast<Eigen::Index>(i)));
+    }
+}
+
+
+std::vector<int> BoTSORT::_select_ambiguous_detections(
+        const CostMatrix &iou_dists_mask,
+        const std::vector<std::shared_ptr<Track>> &tracks) const
+{
+    // Number of candidate pairs (inside the IoU gate) per track and per detection
+    Eigen::VectorXi track_candidates =
+            (iou_dists_mask.array() == 0.0F).rowwise().count().cast<int>();
+    Eigen::RowVectorXi detection_candidates =
+            (iou_dists_mask.array() == 0.0F).colwise().count().cast<int>();
+
+    std::vector<int> ambiguous_detections;
+    for (Eigen::Index j = 0; j < iou_dists_mask.cols(); j++)
+    {
+        bool ambiguous = detection_candidates(j) != 1;
+        for (Eigen::Index i = 0; i < iou_dists_mask.rows() && !ambiguous; i++)
+        {
+            if (iou_dists_mask(i, j) == 0.0F)
+            {
+                // The only candidate track conflicts with other detections, or it is a lost
+                // track which is recovered more reliably with appearance, or its feature is stale
+                ambiguous = track_candidates(i) > 1 ||
+                            tracks[i]->state != TrackState::Tracked ||
+                            (_lazy_reid_refresh_interval > 0 &&
+                             _frame_id - tracks[i]->feature_frame() >=
+                                     _lazy_reid_refresh_interval);
+            }
+        }
+
+        if (ambiguous)
+        {
+            ambiguous_detections.push_back(static_cast<int>(j));
+        }
+    }
+    return ambiguous_detections;
 }
 
 
@@ -525,6 +842,10 @@ void BoTSORT::_load_params_from_config(const std::string &config_path)
 
     _reid_enabled =
             tracker_config.GetBoolean(tracker_name, "enable_reid", false);
+    _lazy_reid = tracker_config.GetBoolean(tracker_name, "lazy_reid", false);
+    _lazy_reid_refresh_interval = static_cast<unsigned int>(std::max(
+            0L, tracker_config.GetInteger(tracker_name,
+                                          "lazy_reid_refresh_interval", 30)));
     _gmc_enabled = tracker_config.GetBoolean(tracker_name, "enable_gmc", false);
     _track_high_thresh =
             tracker_config.GetFloat(tracker_name, "track_high_thresh", 0.6F);
@@ -546,5 +867,101 @@ void BoTSORT::_load_params_from_config(const std::string &config_path)
 
     _frame_rate = tracker_config.GetInteger(tracker_name, "frame_rate", 30);
     _lambda = tracker_config.GetFloat(tracker_name, "lambda", 0.985F);
+    _num_worker_threads = static_cast<uint8_t>(
+            tracker_config.GetInteger(tracker_name, "num_worker_threads", 2));
+    _long_lost_thresh = static_cast<unsigned int>(std::max(
+            0L, tracker_config.GetInteger(tracker_name, "long_lost_thresh", 0)));
+    _kalman_steady_state_after = static_cast<int>(tracker_config.GetInteger(
+            tracker_name, "kalman_steady_state_after", 0));
+
+    // Motion model of the tracks, overridden per class by the <motion_model>_classes lists
+    const std::string motion_model_name =
+            tracker_config.Get(tracker_name, "motion_model", "constant_velocity");
+    if (MotionModel::motion_model_map.find(motion_model_name) ==
+        MotionModel::motion_model_map.end())
+    {
+        std::cout << "Invalid motion model " << motion_model_name
+                  << " passed. Only 'constant_velocity', 'acceleration' and "
+                     "'static' are supported."
+                  << std::endl;
+        exit(1);
+    }
+    _motion_model_type = MotionModel::motion_model_map[motion_model_name];
+    for (const auto &[name, type]: MotionModel::motion_model_map)
+    {
+        for (int class_id: tracker_config.GetList<int>(tracker_name,
+                                                       name + "_classes"))
+        {
+            _class_motion_model_types[static_cast<uint8_t>(class_id)] = type;
+        }
+    }
+    _feat_history_size = static_cast<int>(
+            tracker_config.GetInteger(tracker_name, "feat_history_size", 50));
+    _gallery_matching =
+            tracker_config.GetBoolean(tracker_name, "gallery_matching", false);
+
+    _long_term_reid_enabled = tracker_config.GetBoolean(
+            tracker_name, "enable_long_term_reid", false);
+    _long_term_capacity = static_cast<int>(tracker_config.GetInteger(
+            tracker_name, "long_term_capacity", 4096));
+    _long_term_max_age = static_cast<unsigned int>(tracker_config.GetInteger(
+            tracker_name, "long_term_max_age", 9000));
+    _long_term_thresh =
+            tracker_config.GetFloat(tracker_name, "long_term_thresh", 0.2F);
+    _ivf_lists = static_cast<int>(
+            tracker_config.GetInteger(tracker_name, "long_term_ivf_lists", 64));
+    _ivf_probes = static_cast<int>(tracker_config.GetInteger(
+            tracker_name, "long_term_ivf_probes", 8));
+
+    // Solver of each association stage, assignment_solver unless overridden for the stage
+    const std::string assignment_solver =
+            tracker_config.Get(tracker_name, "assignment_solver", "lapjv");
+    AssignmentOptions assignment_options;
+    assignment_options.auction_epsilon =
+            tracker_config.GetFloat(tracker_name, "auction_epsilon", 1e-4F);
+    assignment_options.time_budget_us = tracker_config.GetFloat(
+            tracker_name, "assignment_time_budget_us", 1000.0F);
+    _assignment_warm_start = tracker_config.GetBoolean(
+            tracker_name, "assignment_warm_start", true);
+
+    auto stage_assignment_options = [&](const std::string &stage_key) {
+        AssignmentOptions options = assignment_options;
+        const std::string solver_name =
+                tracker_config.Get(tracker_name, stage_key, assignment_solver);
+        if (solver_name == "lapjv")
+        {
+            options.solver = AssignmentSolver::LAPJV;
+        }
+        else if (solver_name == "auction")
+        {
+            options.solver = AssignmentSolver::Auction;
+        }
+        else if (solver_name == "greedy")
+        {
+            options.solver = AssignmentSolver::Greedy;
+        }
+        else if (solver_name == "budgeted")
+        {
+            options.solver = AssignmentSolver::Budgeted;
+        }
+        else
+        {
+            std::cout << "Invalid assignment solver " << solver_name
+                      << " passed for " << stage_key
+                      << ". Only 'lapjv', 'auction', 'greedy' and 'budgeted' "
+                         "are supported."
+                      << std::endl;
+            exit(1);
+        }
+        return options;
+    };
+    _first_assignment_options =
+            stage_assignment_options("first_association_solver");
+    _second_assignment_options =
+            stage_assignment_options("second_association_solver");
+    _long_lost_assignment_options =
+            stage_assignment_options("long_lost_association_solver");
+    _unconfirmed_assignment_options =
+            stage_assignment_options("unconfirmed_association_solver");
 }    
 }
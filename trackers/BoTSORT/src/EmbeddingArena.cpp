@@ -0,0 +1,96 @@
+#include "EmbeddingArena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace botsort
+{
+
+FeatureGallery::FeatureGallery(std::shared_ptr<EmbeddingArena> arena,
+                               float *block, int capacity)
+    : _arena(std::move(arena)), _block(block), _capacity(capacity), _size(0),
+      _next(0)
+{
+}
+
+FeatureGallery::~FeatureGallery()
+{
+    _arena->_release(_block);
+}
+
+void FeatureGallery::push(const FeatureVector &feat)
+{
+    std::copy_n(feat.data(), FEATURE_DIM,
+                _block + static_cast<size_t>(_next) * FEATURE_DIM);
+    _next = (_next + 1) % _capacity;
+    _size = std::min(_size + 1, _capacity);
+}
+
+int FeatureGallery::size() const
+{
+    return _size;
+}
+
+FeatureRowsView FeatureGallery::features() const
+{
+    return FeatureRowsView(_block, _size, FEATURE_DIM);
+}
+
+
+EmbeddingArena::EmbeddingArena(int gallery_capacity, int galleries_per_page)
+    : _gallery_capacity(std::max(1, gallery_capacity)),
+      _galleries_per_page(std::max(1, galleries_per_page))
+{
+}
+
+std::unique_ptr<FeatureGallery> EmbeddingArena::acquire()
+{
+    float *block;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_free_blocks.empty())
+        {
+            _grow();
+        }
+        block = _free_blocks.back();
+        _free_blocks.pop_back();
+    }
+    return std::make_unique<FeatureGallery>(shared_from_this(), block,
+                                            _gallery_capacity);
+}
+
+int EmbeddingArena::gallery_capacity() const
+{
+    return _gallery_capacity;
+}
+
+void EmbeddingArena::_release(float *block)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free_blocks.push_back(block);
+}
+
+void EmbeddingArena::_grow()
+{
+    // Each feature vector is FEATURE_DIM floats, i.e. a multiple of the 64-byte cache line,
+    // so every gallery and every row inside it starts on a cache line boundary
+    const size_t block_floats =
+            static_cast<size_t>(_gallery_capacity) * FEATURE_DIM;
+    const size_t page_bytes =
+            block_floats * _galleries_per_page * sizeof(float);
+
+    auto *page = static_cast<float *>(std::aligned_alloc(_alignment, page_bytes));
+    if (page == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    _pages.emplace_back(page, &std::free);
+
+    // Push in reverse so that galleries are handed out in address order
+    for (int i = _galleries_per_page - 1; i >= 0; i--)
+    {
+        _free_blocks.push_back(page + i * block_floats);
+    }
+}
+
+}// namespace botsort
@@ -0,0 +1,263 @@
+#include "IdentityMemory.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace botsort
+{
+
+using ConstFeatureRowsMap = Eigen::Map<
+        const Eigen::Matrix<float, Eigen::Dynamic, FEATURE_DIM, Eigen::RowMajor>>;
+using ConstFeatureMap = Eigen::Map<const FeatureVector>;
+
+IdentityMemory::IdentityMemory(int capacity, int num_lists, int num_probes,
+                               unsigned int max_age)
+    : _capacity(std::max(1, capacity)), _num_lists(std::max(1, num_lists)),
+      _num_probes(std::max(1, num_probes)), _max_age(max_age),
+      _lists(1), _inserts_since_training(0)
+{
+}
+
+void IdentityMemory::insert(int track_id, uint8_t class_id,
+                            const FeatureVector &feat, unsigned int frame_id)
+{
+    _remove(track_id);
+    while (_locations.size() >= static_cast<size_t>(_capacity))
+    {
+        auto [oldest_id, oldest_frame] = _insertion_order.front();
+        _insertion_order.pop_front();
+
+        auto location = _locations.find(oldest_id);
+        if (location != _locations.end() &&
+            _lists[location->second.list].frame_ids[location->second.slot] ==
+                    oldest_frame)
+        {
+            _remove(oldest_id);
+        }
+    }
+
+    FeatureVector normalized_feat = feat.normalized();
+    _add_to_index(track_id, class_id, normalized_feat.data(), frame_id);
+    _insertion_order.emplace_back(track_id, frame_id);
+    _inserts_since_training++;
+
+    // Train the index once there are enough identities to fill the lists, and retrain it
+    // once the stored identities have been renewed so that the centroids follow the data
+    const size_t min_training_size =
+            static_cast<size_t>(_num_lists) * _min_points_per_list;
+    if (_locations.size() >= min_training_size &&
+        (_centroids.rows() == 0 || _inserts_since_training >= _locations.size()))
+    {
+        _train();
+    }
+}
+
+std::optional<IdentityMemory::Match>
+IdentityMemory::query(const FeatureVector &feat, uint8_t class_id,
+                      float max_distance)
+{
+    FeatureVector normalized_feat = feat.normalized();
+
+    // Inverted lists to scan, closest centroids first
+    std::vector<int> probed_lists(_lists.size());
+    std::iota(probed_lists.begin(), probed_lists.end(), 0);
+    if (_centroids.rows() > 0 && _num_probes < static_cast<int>(_lists.size()))
+    {
+        Eigen::VectorXf centroid_similarities =
+                _centroids * normalized_feat.transpose();
+        std::partial_sort(probed_lists.begin(),
+                          probed_lists.begin() + _num_probes,
+                          probed_lists.end(), [&](int a, int b) {
+                              return centroid_similarities(a) >
+                                     centroid_similarities(b);
+                          });
+        probed_lists.resize(_num_probes);
+    }
+
+    std::optional<Match> best_match;
+    for (int list_idx: probed_lists)
+    {
+        const InvertedList &list = _lists[list_idx];
+        if (list.track_ids.empty())
+        {
+            continue;
+        }
+
+        ConstFeatureRowsMap features(list.features.data(),
+                                     static_cast<Eigen::Index>(list.track_ids.size()),
+                                     FEATURE_DIM);
+        Eigen::VectorXf similarities = features * normalized_feat.transpose();
+        for (size_t slot = 0; slot < list.track_ids.size(); slot++)
+        {
+            if (list.class_ids[slot] != class_id)
+            {
+                continue;
+            }
+
+            float distance = std::max(
+                    0.0f, 1.0f - similarities(static_cast<Eigen::Index>(slot)));
+            if (distance <= max_distance &&
+                (!best_match || distance < best_match->distance))
+            {
+                best_match = Match{list.track_ids[slot], distance};
+            }
+        }
+    }
+
+    // An identity can only be recovered once
+    if (best_match)
+    {
+        _remove(best_match->track_id);
+    }
+    return best_match;
+}
+
+void IdentityMemory::evict_expired(unsigned int frame_id)
+{
+    while (!_insertion_order.empty() &&
+           frame_id - _insertion_order.front().second > _max_age)
+    {
+        auto [oldest_id, oldest_frame] = _insertion_order.front();
+        _insertion_order.pop_front();
+
+        auto location = _locations.find(oldest_id);
+        if (location != _locations.end() &&
+            _lists[location->second.list].frame_ids[location->second.slot] ==
+                    oldest_frame)
+        {
+            _remove(oldest_id);
+        }
+    }
+}
+
+size_t IdentityMemory::size() const
+{
+    return _locations.size();
+}
+
+void IdentityMemory::_add_to_index(int track_id, uint8_t class_id,
+                                   const float *feat, unsigned int frame_id)
+{
+    const int list_idx = _closest_list(feat);
+    InvertedList &list = _lists[list_idx];
+
+    list.features.insert(list.features.end(), feat, feat + FEATURE_DIM);
+    list.track_ids.push_back(track_id);
+    list.class_ids.push_back(class_id);
+    list.frame_ids.push_back(frame_id);
+    _locations[track_id] = {list_idx, list.track_ids.size() - 1};
+}
+
+void IdentityMemory::_remove(int track_id)
+{
+    auto location = _locations.find(track_id);
+    if (location == _locations.end())
+    {
+        return;
+    }
+
+    InvertedList &list = _lists[location->second.list];
+    const size_t slot = location->second.slot;
+    const size_t last = list.track_ids.size() - 1;
+    if (slot != last)
+    {
+        std::copy_n(list.features.begin() + last * FEATURE_DIM, FEATURE_DIM,
+                    list.features.begin() + slot * FEATURE_DIM);
+        list.track_ids[slot] = list.track_ids[last];
+        list.class_ids[slot] = list.class_ids[last];
+        list.frame_ids[slot] = list.frame_ids[last];
+        _locations[list.track_ids[slot]].slot = slot;
+    }
+
+    list.features.resize(last * FEATURE_DIM);
+    list.track_ids.pop_back();
+    list.class_ids.pop_back();
+    list.frame_ids.pop_back();
+    _locations.erase(location);
+}
+
+int IdentityMemory::_closest_list(const float *feat) const
+{
+    if (_centroids.rows() == 0)
+    {
+        return 0;
+    }
+
+    Eigen::Index closest;
+    (_centroids * ConstFeatureMap(feat).transpose()).maxCoeff(&closest);
+    return static_cast<int>(closest);
+}
+
+void IdentityMemory::_train()
+{
+    // Gather all the stored identities
+    const auto num_points = static_cast<Eigen::Index>(_locations.size());
+    FeatureRows points(num_points, FEATURE_DIM);
+    std::vector<int> track_ids;
+    std::vector<uint8_t> class_ids;
+    std::vector<unsigned int> frame_ids;
+    track_ids.reserve(num_points);
+    class_ids.reserve(num_points);
+    frame_ids.reserve(num_points);
+
+    for (const InvertedList &list: _lists)
+    {
+        for (size_t slot = 0; slot < list.track_ids.size(); slot++)
+        {
+            points.row(static_cast<Eigen::Index>(track_ids.size())) =
+                    ConstFeatureMap(list.features.data() + slot * FEATURE_DIM);
+            track_ids.push_back(list.track_ids[slot]);
+            class_ids.push_back(list.class_ids[slot]);
+            frame_ids.push_back(list.frame_ids[slot]);
+        }
+    }
+
+    // Spherical k-means: the features are normalized, points are assigned to the centroid with the
+    // highest cosine similarity and centroids are re-normalized after each update.
+    // Centroids are seeded with evenly spaced points, which keeps the tracker deterministic.
+    const auto num_lists = static_cast<Eigen::Index>(_num_lists);
+    _centroids.resize(num_lists, FEATURE_DIM);
+    for (Eigen::Index k = 0; k < num_lists; k++)
+    {
+        _centroids.row(k) = points.row(k * num_points / num_lists);
+    }
+
+    std::vector<Eigen::Index> assignments(num_points, 0);
+    for (int iteration = 0; iteration < _kmeans_iterations; iteration++)
+    {
+        Eigen::MatrixXf similarities = points * _centroids.transpose();
+        for (Eigen::Index i = 0; i < num_points; i++)
+        {
+            similarities.row(i).maxCoeff(&assignments[i]);
+        }
+
+        FeatureRows sums = FeatureRows::Zero(num_lists, FEATURE_DIM);
+        std::vector<int> counts(num_lists, 0);
+        for (Eigen::Index i = 0; i < num_points; i++)
+        {
+            sums.row(assignments[i]) += points.row(i);
+            counts[assignments[i]]++;
+        }
+
+        for (Eigen::Index k = 0; k < num_lists; k++)
+        {
+            // Empty clusters keep their previous centroid
+            if (counts[k] > 0)
+            {
+                _centroids.row(k) = sums.row(k).normalized();
+            }
+        }
+    }
+
+    // Rebuild the inverted lists around the trained centroids
+    _lists.assign(_num_lists, InvertedList());
+    _locations.clear();
+    for (Eigen::Index i = 0; i < num_points; i++)
+    {
+        _add_to_index(track_ids[i], class_ids[i], points.row(i).data(),
+                      frame_ids[i]);
+    }
+    _inserts_since_training = 0;
+}
+
+}// namespace botsort
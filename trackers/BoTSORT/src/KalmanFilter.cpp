@@ -1,20 +1,22 @@
 #include "KalmanFilter.h"
 
-#include <eigen3/Eigen/Cholesky>
-
 namespace botsort
 {
 namespace bot_kalman
 {
-KalmanFilter::KalmanFilter(double dt)
-    : _std_weight_position(1.0 / 20), _std_weight_velocity(1.0 / 160)
+KalmanFilter::KalmanFilter(double dt, int steady_state_after)
+    : _std_weight_position(1.0 / 20), _std_weight_velocity(1.0 / 160),
+      _steady_state_after(steady_state_after)
 {
 
     _init_kf_matrices(dt);
+    _init_steady_state();
 }
 
 void KalmanFilter::_init_kf_matrices(double dt)
 {
+    _dt = static_cast<float>(dt);
+
     // This is a 4x8 matrix that maps the 8-dimensional state space vector [x, y, w, h, vx, vy, vw, vh]
     // to the 4-dimensional measurement space vector [x, y, w, h]
     _measurement_matrix.setIdentity();
@@ -28,6 +30,56 @@ void KalmanFilter::_init_kf_matrices(double dt)
     }
 }
 
+void KalmanFilter::_init_steady_state()
+{
+    // Riccati recursion of one axis of a unit box, from the initial covariance of init()
+    const Eigen::Matrix2d transition{{1.0, _dt}, {0.0, 1.0}};
+    const Eigen::Matrix2d motion_cov =
+            Eigen::Vector2d(_std_weight_position * _std_weight_position,
+                            _std_weight_velocity * _std_weight_velocity)
+                    .asDiagonal();
+    const double measurement_var = _std_weight_position * _std_weight_position;
+
+    Eigen::Matrix2d posterior =
+            Eigen::Vector2d(4 * motion_cov(0, 0), 100 * motion_cov(1, 1))
+                    .asDiagonal();
+    Eigen::Matrix2d prior;
+    Eigen::Vector2d gain;
+    for (int i = 0; i < 100000; i++)
+    {
+        prior = transition * posterior * transition.transpose() + motion_cov;
+        gain = prior.col(0) / (prior(0, 0) + measurement_var);
+
+        const Eigen::Matrix2d previous = posterior;
+        posterior = prior - gain * prior.row(0);
+        if ((posterior - previous).cwiseAbs().maxCoeff() <=
+            1e-12 * posterior.cwiseAbs().maxCoeff())
+        {
+            break;
+        }
+    }
+
+    _steady_gain_position = static_cast<float>(gain(0));
+    _steady_gain_velocity = static_cast<float>(gain(1));
+    _steady_prior_covariance = prior.cast<float>();
+}
+
+void KalmanFilter::_set_steady_state_covariance(
+        const KFStateSpaceVec &mean, const Eigen::Matrix2f &unit_covariance,
+        KFStateSpaceMatrix &covariance)
+{
+    covariance.setZero();
+    for (Eigen::Index i = 0; i < 4; i++)
+    {
+        const float size = mean(2 + i % 2);
+        const float scale = size * size;
+        covariance(i, i) = scale * unit_covariance(0, 0);
+        covariance(i, i + 4) = covariance(i + 4, i) =
+                scale * unit_covariance(0, 1);
+        covariance(i + 4, i + 4) = scale * unit_covariance(1, 1);
+    }
+}
+
 KFDataStateSpace KalmanFilter::init(const DetVec &measurement) const
 {
     constexpr float init_velocity = 0.0;
@@ -49,97 +101,134 @@ KFDataStateSpace KalmanFilter::init(const DetVec &measurement) const
     return {mean_state_space, covariance};
 }
 
+void KalmanFilter::_transition(KFStateSpaceVec &mean,
+                               KFStateSpaceMatrix &covariance, float step)
+{
+    mean.head<4>() += step * mean.tail<4>();
+
+    // With covariance = [A, B; B^T, C] and F = [I, step*I; 0, I]:
+    //   F * covariance * F^T = [A + step*(B + U^T), U; U^T, C], with U = B + step*C
+    const Eigen::Matrix4f B = covariance.topRightCorner<4, 4>();
+    const Eigen::Matrix4f U = B + step * covariance.bottomRightCorner<4, 4>();
+    covariance.topLeftCorner<4, 4>() += step * (B + U.transpose());
+    covariance.topRightCorner<4, 4>() = U;
+    covariance.bottomLeftCorner<4, 4>() = U.transpose();
+}
+
+void KalmanFilter::predict(KFStateSpaceVec &mean,
+                           KFStateSpaceMatrix &covariance) const
+{
+    const Eigen::Array4f std_size(mean(2), mean(3), mean(2), mean(3));
+
+    _transition(mean, covariance, _dt);
+
+    covariance.topLeftCorner<4, 4>().diagonal().array() +=
+            (_std_weight_position * std_size).square();
+    covariance.bottomRightCorner<4, 4>().diagonal().array() +=
+            (_std_weight_velocity * std_size).square();
+}
+
 void KalmanFilter::predict(KFStateSpaceVec &mean,
-                           KFStateSpaceMatrix &covariance)
+                           KFStateSpaceMatrix &covariance, int steps) const
 {
-    Eigen::VectorXf std_combined;
-    std_combined.resize(KALMAN_STATE_SPACE_DIM);
-    std_combined << mean(2), mean(3), mean(2), mean(3), mean(2), mean(3),
-            mean(2), mean(3);
-    std_combined.head<4>().array() *= _std_weight_position;
-    std_combined.tail<4>().array() *= _std_weight_velocity;
-    KFStateSpaceMatrix motion_cov =
-            std_combined.array().square().matrix().asDiagonal();
-
-    mean = _state_transition_matrix.lazyProduct(mean.transpose());
-    covariance = (_state_transition_matrix * covariance)
-                         .lazyProduct(_state_transition_matrix.transpose()) +
-                 motion_cov;
+    if (steps <= 0)
+    {
+        return;
+    }
+
+    // With F = [I, dt*I; 0, I], n steps give F^n = [I, n*dt*I; 0, I] and
+    //   P_n = F^n * P * F^n' + sum_{k=0}^{n-1} F^k * Q * F^k'
+    // The motion noise Q = diag(Qp, Qv) is diagonal and constant, so the sum reduces to
+    //   [n*Qp + dt^2*S2*Qv, dt*S1*Qv; dt*S1*Qv, n*Qv], with S1 = sum k and S2 = sum k^2
+    const auto n = static_cast<float>(steps);
+    const float s1 = n * (n - 1) / 2;
+    const float s2 = n * (n - 1) * (2 * n - 1) / 6;
+
+    Eigen::Vector4f std_size(mean(2), mean(3), mean(2), mean(3));
+    Eigen::Vector4f motion_var_position =
+            (_std_weight_position * std_size).array().square();
+    Eigen::Vector4f motion_var_velocity =
+            (_std_weight_velocity * std_size).array().square();
+
+    _transition(mean, covariance, n * _dt);
+
+    covariance.topLeftCorner<4, 4>().diagonal() +=
+            n * motion_var_position + _dt * _dt * s2 * motion_var_velocity;
+    covariance.topRightCorner<4, 4>().diagonal() +=
+            _dt * s1 * motion_var_velocity;
+    covariance.bottomLeftCorner<4, 4>().diagonal() +=
+            _dt * s1 * motion_var_velocity;
+    covariance.bottomRightCorner<4, 4>().diagonal() += n * motion_var_velocity;
+}
+
+void KalmanFilter::predict_steady_state(KFStateSpaceVec &mean,
+                                        KFStateSpaceMatrix &covariance) const
+{
+    // The motion noise of predict() uses the size before the prediction
+    _set_steady_state_covariance(mean, _steady_prior_covariance, covariance);
+    mean.head<4>() += _dt * mean.tail<4>();
 }
 
 KFDataMeasurementSpace
 KalmanFilter::project(const KFStateSpaceVec &mean,
                       const KFStateSpaceMatrix &covariance) const
 {
-    KFMeasSpaceVec innovation_cov =
-            (_std_weight_position *
-             Eigen::Vector4f(mean(2), mean(3), mean(2), mean(3)))
-                    .array()
-                    .square()
-                    .matrix();
-    KFMeasSpaceMatrix innovation_cov_diag = innovation_cov.asDiagonal();
-
-    KFMeasSpaceVec mean_projected =
-            _measurement_matrix.lazyProduct(mean.transpose());
+    // H = [I, 0] selects the position and size: H * covariance * H^T is the top-left block
+    KFMeasSpaceVec mean_projected = mean.head<4>();
     KFMeasSpaceMatrix covariance_projected =
-            (_measurement_matrix * covariance)
-                    .lazyProduct(_measurement_matrix.transpose()) +
-            innovation_cov_diag;
+            covariance.topLeftCorner<4, 4>();
+    covariance_projected.diagonal().array() +=
+            (_std_weight_position *
+             Eigen::Array4f(mean(2), mean(3), mean(2), mean(3)))
+                    .square();
     return {mean_projected, covariance_projected};
 }
 
 KFDataStateSpace KalmanFilter::update(const KFStateSpaceVec &mean,
                                       const KFStateSpaceMatrix &covariance,
-                                      const DetVec &measurement)
+                                      const DetVec &measurement) const
 {
     KFDataMeasurementSpace projected = project(mean, covariance);
     KFMeasSpaceVec projected_mean = projected.first;
-    KFMeasSpaceMatrix projected_covariance = projected.second;
 
-    Eigen::Matrix<float, KALMAN_MEASUREMENT_SPACE_DIM, KALMAN_STATE_SPACE_DIM>
-            B = (covariance * _measurement_matrix.transpose()).transpose();
-    Eigen::Matrix<float, KALMAN_STATE_SPACE_DIM, KALMAN_MEASUREMENT_SPACE_DIM>
-            kalman_gain = (projected_covariance.llt().solve(B)).transpose();
+    // The fixed-size 4x4 inverse is computed in closed form (cofactors), and with H = [I, 0]:
+    //   K = covariance * H^T * S^-1 = covariance.leftCols(4) * S^-1
+    //   K * S * K^T = K * H * covariance = K * covariance.topRows(4)
+    const KFMeasSpaceMatrix projected_covariance_inv =
+            projected.second.inverse();
+    const Eigen::Matrix<float, KALMAN_STATE_SPACE_DIM,
+                        KALMAN_MEASUREMENT_SPACE_DIM>
+            kalman_gain = covariance.leftCols<KALMAN_MEASUREMENT_SPACE_DIM>() *
+                          projected_covariance_inv;
     Eigen::Matrix<float, 1, KALMAN_MEASUREMENT_SPACE_DIM> innovation =
             measurement - projected_mean;
 
     KFStateSpaceVec mean_updated = mean + innovation * kalman_gain.transpose();
     KFStateSpaceMatrix covariance_updated =
             covariance -
-            kalman_gain * projected_covariance * kalman_gain.transpose();
+            kalman_gain * covariance.topRows<KALMAN_MEASUREMENT_SPACE_DIM>();
     return {mean_updated, covariance_updated};
 }
 
-
-Eigen::Matrix<float, 1, Eigen::Dynamic> KalmanFilter::gating_distance(
-        const KFStateSpaceVec &mean, const KFStateSpaceMatrix &covariance,
-        const std::vector<DetVec> &measurements, bool only_position) const
+KFDataStateSpace
+KalmanFilter::update_steady_state(const KFStateSpaceVec &mean,
+                                  const KFStateSpaceMatrix &covariance,
+                                  const DetVec &measurement) const
 {
-    KFDataMeasurementSpace projected = this->project(mean, covariance);
-    KFMeasSpaceVec projected_mean = projected.first;
-    KFMeasSpaceMatrix projected_covariance = projected.second;
-
-    if (only_position)
-    {
-        projected_mean.tail<4>().setZero();
-        projected_covariance.bottomRightCorner<2, 2>().setZero();
-    }
-
-    Eigen::LLT<Eigen::MatrixXf> lltOfProjectedCovariance(projected_covariance);
-    Eigen::Matrix<float, 1, Eigen::Dynamic> mahalanobis_distances(
-            measurements.size());
-    mahalanobis_distances.setZero();
-
-    for (Eigen::Index i = 0; i < measurements.size(); i++)
-    {
-        Eigen::VectorXf diff = measurements[i] - projected_mean;
-        // Solve for y in Ly = diff using forward substitution, more efficient than computing the inverse
-        Eigen::VectorXf y = lltOfProjectedCovariance.matrixL().solve(diff);
-        // Mahalanobis distance is the norm of y
-        mahalanobis_distances(i) = y.squaredNorm();
-    }
-
-    return mahalanobis_distances;
+    const Eigen::Matrix<float, 1, KALMAN_MEASUREMENT_SPACE_DIM> innovation =
+            measurement - mean.head<4>();
+
+    KFStateSpaceVec mean_updated = mean;
+    mean_updated.head<4>() += _steady_gain_position * innovation;
+    mean_updated.tail<4>() += _steady_gain_velocity * innovation;
+
+    // With the gain K = [gp * I; gv * I], (I - K * H) * covariance only scales the first four rows
+    KFStateSpaceMatrix covariance_updated = covariance;
+    covariance_updated.topRows<4>() -=
+            _steady_gain_position * covariance.topRows<4>();
+    covariance_updated.bottomRows<4>() -=
+            _steady_gain_velocity * covariance.topRows<4>();
+    return {mean_updated, covariance_updated};
 }
 }// namespace bot_kalman        
 }
@@ -78,7 +78,7 @@ KFDataStateSpace KalmanFilter::init(const DetVec &measurement) const
 }
 
 void KalmanFilter::predict(KFStateSpaceVec &mean,
-                           KFStateSpaceMatrix &covariance)
+                           KFStateSpaceMatrix &covariance) const
 {
     float std = _std_factor_acceleration * std::max(mean(2), mean(3)) +
                 _std_offset_acceleration;
@@ -91,6 +91,13 @@ void KalmanFilter::predict(KFStateSpaceVec &mean,
                  motion_cov;
 }
 
+KFDataMeasurementSpace
+KalmanFilter::project(const KFStateSpaceVec &mean,
+                      const KFStateSpaceMatrix &covariance) const
+{
+    return project(mean, covariance, false);
+}
+
 KFDataMeasurementSpace
 KalmanFilter::project(const KFStateSpaceVec &mean,
                       const KFStateSpaceMatrix &covariance,
@@ -119,7 +126,7 @@ KalmanFilter::project(const KFStateSpaceVec &mean,
 
 KFDataStateSpace KalmanFilter::update(const KFStateSpaceVec &mean,
                                       const KFStateSpaceMatrix &covariance,
-                                      const DetVec &measurement)
+                                      const DetVec &measurement) const
 {
     KFDataMeasurementSpace projected = project(mean, covariance);
     KFMeasSpaceVec projected_mean = projected.first;
@@ -139,37 +146,6 @@ KFDataStateSpace KalmanFilter::update(const KFStateSpaceVec &mean,
     return std::make_pair(mean_updated, covariance_updated);
 }
 
-
-Eigen::Matrix<float, 1, Eigen::Dynamic> KalmanFilter::gating_distance(
-        const KFStateSpaceVec &mean, const KFStateSpaceMatrix &covariance,
-        const std::vector<DetVec> &measurements, bool only_position) const
-{
-    KFDataMeasurementSpace projected = this->project(mean, covariance);
-    KFMeasSpaceVec projected_mean = projected.first;
-    KFMeasSpaceMatrix projected_covariance = projected.second;
-
-    if (only_position)
-    {
-        projected_mean.tail<4>().setZero();
-        projected_covariance.bottomRightCorner<2, 2>().setZero();
-    }
-
-    Eigen::LLT<Eigen::MatrixXf> lltOfProjectedCovariance(projected_covariance);
-    Eigen::Matrix<float, 1, Eigen::Dynamic> mahalanobis_distances(
-            measurements.size());
-    mahalanobis_distances.setZero();
-
-    for (Eigen::Index i = 0; i < measurements.size(); i++)
-    {
-        Eigen::VectorXf diff = measurements[i] - projected_mean;
-        // Solve for y in Ly = diff using forward substitution, more efficient than computing the inverse
-        Eigen::VectorXf y = lltOfProjectedCovariance.matrixL().solve(diff);
-        // Mahalanobis distance is the norm of y
-        mahalanobis_distances(i) = y.squaredNorm();
-    }
-
-    return mahalanobis_distances;
-}
 }// namespace acc_kalman
         
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "KalmanFilterStatic.h"
+
+namespace botsort
+{
+namespace static_kalman
+{
+KalmanFilter::KalmanFilter()
+    : _std_weight_position(1.0 / 20), _std_weight_drift(1.0 / 160)
+{
+}
+
+KFDataStateSpace KalmanFilter::init(const DetVec &measurement) const
+{
+    KFStateSpaceVec mean_state_space;
+    mean_state_space.head<4>() = measurement.head<4>();
+    mean_state_space.tail<4>().setZero();
+
+    float w = measurement(2), h = measurement(3);
+    KFStateSpaceMatrix covariance = KFStateSpaceMatrix::Zero();
+    covariance.topLeftCorner<4, 4>().diagonal() =
+            (2 * _std_weight_position * Eigen::Array4f(w, h, w, h))
+                    .square()
+                    .matrix();
+    return {mean_state_space, covariance};
+}
+
+void KalmanFilter::predict(KFStateSpaceVec &mean,
+                           KFStateSpaceMatrix &covariance) const
+{
+    _pin_velocity(mean, covariance);
+    covariance.topLeftCorner<4, 4>().diagonal().array() +=
+            (_std_weight_drift *
+             Eigen::Array4f(mean(2), mean(3), mean(2), mean(3)))
+                    .square();
+}
+
+void KalmanFilter::predict(KFStateSpaceVec &mean,
+                           KFStateSpaceMatrix &covariance, int steps) const
+{
+    if (steps <= 0)
+    {
+        return;
+    }
+
+    // The mean does not move, so the drift noise is the same at every step
+    _pin_velocity(mean, covariance);
+    covariance.topLeftCorner<4, 4>().diagonal().array() +=
+            static_cast<float>(steps) *
+            (_std_weight_drift *
+             Eigen::Array4f(mean(2), mean(3), mean(2), mean(3)))
+                    .square();
+}
+
+void KalmanFilter::_pin_velocity(KFStateSpaceVec &mean,
+                                 KFStateSpaceMatrix &covariance)
+{
+    mean.tail<4>().setZero();
+    covariance.bottomRows<4>().setZero();
+    covariance.rightCols<4>().setZero();
+}
+
+KFDataMeasurementSpace
+KalmanFilter::project(const KFStateSpaceVec &mean,
+                      const KFStateSpaceMatrix &covariance) const
+{
+    KFMeasSpaceVec mean_projected = mean.head<4>();
+    KFMeasSpaceMatrix covariance_projected =
+            covariance.topLeftCorner<4, 4>();
+    covariance_projected.diagonal().array() +=
+            (_std_weight_position *
+             Eigen::Array4f(mean(2), mean(3), mean(2), mean(3)))
+                    .square();
+    return {mean_projected, covariance_projected};
+}
+
+KFDataStateSpace KalmanFilter::update(const KFStateSpaceVec &mean,
+                                      const KFStateSpaceMatrix &covariance,
+                                      const DetVec &measurement) const
+{
+    KFDataMeasurementSpace projected = project(mean, covariance);
+
+    // The velocity block has no variance, so the gain is zero outside of the position block
+    const KFMeasSpaceMatrix position_covariance =
+            covariance.topLeftCorner<4, 4>();
+    const KFMeasSpaceMatrix kalman_gain =
+            position_covariance * projected.second.inverse();
+    const KFMeasSpaceVec innovation = measurement - projected.first;
+
+    KFStateSpaceVec mean_updated = mean;
+    mean_updated.head<4>() += innovation * kalman_gain.transpose();
+    KFStateSpaceMatrix covariance_updated = covariance;
+    covariance_updated.topLeftCorner<4, 4>() -=
+            kalman_gain * position_covariance;
+    return {mean_updated, covariance_updated};
+}
+}// namespace static_kalman
+}
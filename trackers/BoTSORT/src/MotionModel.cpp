@@ -0,0 +1,100 @@
+#include "MotionModel.h"
+
+#include <eigen3/Eigen/Cholesky>
+
+#include "KalmanFilter.h"
+#include "KalmanFilterAccBased.h"
+#include "KalmanFilterStatic.h"
+
+namespace botsort
+{
+std::map<std::string, MotionModelType> MotionModel::motion_model_map = {
+        {"constant_velocity", MotionModelType::ConstantVelocity},
+        {"acceleration", MotionModelType::Acceleration},
+        {"static", MotionModelType::Static},
+};
+
+std::shared_ptr<MotionModel> MotionModel::create(MotionModelType type,
+                                                 double dt,
+                                                 int steady_state_after)
+{
+    if (type == MotionModelType::Acceleration)
+    {
+        return std::make_shared<acc_kalman::KalmanFilter>(dt);
+    }
+    else if (type == MotionModelType::Static)
+    {
+        return std::make_shared<static_kalman::KalmanFilter>();
+    }
+    return std::make_shared<bot_kalman::KalmanFilter>(dt, steady_state_after);
+}
+
+void MotionModel::predict(KFStateSpaceVec &mean, KFStateSpaceMatrix &covariance,
+                          int steps) const
+{
+    for (int step = 0; step < steps; step++)
+    {
+        predict(mean, covariance);
+    }
+}
+
+Eigen::Matrix<float, 1, Eigen::Dynamic> MotionModel::gating_distance(
+        const KFStateSpaceVec &mean, const KFStateSpaceMatrix &covariance,
+        const std::vector<DetVec> &measurements, bool only_position) const
+{
+    const auto num_measurements = static_cast<Eigen::Index>(measurements.size());
+    KFMeasSpaceBatch measurement_batch(KALMAN_MEASUREMENT_SPACE_DIM,
+                                       num_measurements);
+    for (Eigen::Index i = 0; i < num_measurements; i++)
+    {
+        measurement_batch.col(i) = measurements[i].transpose();
+    }
+
+    Eigen::Matrix<float, 1, Eigen::Dynamic> mahalanobis_distances(
+            num_measurements);
+    gating_distance(mean, covariance, measurement_batch, mahalanobis_distances,
+                    only_position);
+    return mahalanobis_distances;
+}
+
+void MotionModel::gating_distance(const KFStateSpaceVec &mean,
+                                  const KFStateSpaceMatrix &covariance,
+                                  const KFMeasSpaceBatch &measurements,
+                                  Eigen::Ref<Eigen::RowVectorXf> distances,
+                                  bool only_position) const
+{
+    KFDataMeasurementSpace projected = this->project(mean, covariance);
+    const Eigen::Vector4f projected_mean = projected.first.transpose();
+
+    // The squared Mahalanobis distance is ||L^-1 * (z - mean)||^2 with L the Cholesky factor of the projected
+    // covariance. L^-1 is computed once, so each measurement costs a single fixed-size matrix-vector product.
+    if (only_position)
+    {
+        Eigen::LLT<Eigen::Matrix2f> llt_of_projected_covariance(
+                projected.second.topLeftCorner<2, 2>());
+        const Eigen::Matrix2f inverse_L =
+                llt_of_projected_covariance.matrixL().solve(
+                        Eigen::Matrix2f::Identity());
+
+        for (Eigen::Index i = 0; i < measurements.cols(); i++)
+        {
+            distances(i) = (inverse_L * (measurements.col(i).head<2>() -
+                                         projected_mean.head<2>()))
+                                   .squaredNorm();
+        }
+        return;
+    }
+
+    Eigen::LLT<KFMeasSpaceMatrix> llt_of_projected_covariance(
+            projected.second);
+    const KFMeasSpaceMatrix inverse_L =
+            llt_of_projected_covariance.matrixL().solve(
+                    KFMeasSpaceMatrix::Identity());
+
+    for (Eigen::Index i = 0; i < measurements.cols(); i++)
+    {
+        distances(i) =
+                (inverse_L * (measurements.col(i) - projected_mean)).squaredNorm();
+    }
+}
+}// namespace botsort
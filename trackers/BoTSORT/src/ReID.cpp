@@ -1,6 +1,11 @@
 #include "ReID.h"
 #include "INIReader.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <numeric>
 
 namespace botsort
 {
@@ -9,64 +14,84 @@ ReIDModel::ReIDModel(const std::string &config_path, const std::string &onnx_mod
     : _env(ORT_LOGGING_LEVEL_WARNING, "reid_model") {
     std::cout << "Initializing ReID model" << std::endl;
     _load_params_from_config(config_path);
-    _onnx_model_path = onnx_model_path;
     _initialize_onnx_session(onnx_model_path);
 }
 void ReIDModel::_initialize_onnx_session(const std::string &model_path) {
-    // Configure session options
-    _session_options.SetIntraOpNumThreads(1);
-    _session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    // Configure session options, kept whatever execution provider is used
+    _session_options.SetIntraOpNumThreads(_intra_op_num_threads);
+    _session_options.SetInterOpNumThreads(_inter_op_num_threads);
+    _session_options.SetExecutionMode(_parallel_execution ? ExecutionMode::ORT_PARALLEL
+                                                          : ExecutionMode::ORT_SEQUENTIAL);
+    _session_options.SetGraphOptimizationLevel(_graph_optimization_level);
+    if (_enable_cpu_mem_arena) {
+        _session_options.EnableCpuMemArena();
+    } else {
+        _session_options.DisableCpuMemArena();
+    }
+    if (_enable_mem_pattern) {
+        _session_options.EnableMemPattern();
+    } else {
+        _session_options.DisableMemPattern();
+    }
 
     std::vector<std::string> available_providers = Ort::GetAvailableProviders();
-    bool provider_set = false;
+    auto is_available = [&](const std::string &provider_name) {
+        return std::find(available_providers.begin(), available_providers.end(), provider_name) !=
+               available_providers.end();
+    };
 
     // Check if the model file has TensorRT suffix
     bool is_trt_model = (model_path.find(".trt") != std::string::npos) || 
                         (model_path.find(".engine") != std::string::npos);
 
-    // Try to add CUDA provider if available
-    for (const auto& provider : available_providers) 
-    {
-        if (!provider_set && provider.find("CUDA") != std::string::npos) 
-        {
-            try
-            {
-                OrtCUDAProviderOptions cuda_options;
-                _session_options.AppendExecutionProvider_CUDA(cuda_options);  // Use GPU 0
-                provider_set = true;
-                std::cout << "CUDA execution provider set successfully." << std::endl;
-                break;
-            }
-            catch (const Ort::Exception& e) 
-            {
-                std::cerr << "ONNX Runtime error: " << e.what() << std::endl;
-                continue;
-            }                 
-        } 
-
-        // Try to add TensorRT provider if CUDA wasn't added, TensorRT is available, and the model is a TensorRT engine
-        else if (!provider_set && provider.find("Tensorrt") != std::string::npos && is_trt_model) 
-        {
-            try {
-                OrtTensorRTProviderOptions trt_options;
-                _session_options.AppendExecutionProvider_TensorRT(trt_options);
-                provider_set = true;
-                std::cout << "TensorRT execution provider set successfully." << std::endl;
+    // The first execution provider of the preference list that can be added is used,
+    // the CPU provider is always there as the fallback
+    std::string provider_set = "cpu";
+    for (const std::string &provider : _execution_providers) {
+        if (provider == "cpu") {
+            break;
+        }
+
+        // TensorRT is only used for TensorRT engines
+        if (provider == "tensorrt" && !is_trt_model) {
+            continue;
+        }
+
+        const std::string ort_provider = provider == "cuda" ? "CUDAExecutionProvider"
+                                                            : "TensorrtExecutionProvider";
+        if (!is_available(ort_provider)) {
+            std::cerr << "Warning: " << provider << " execution provider requested but " << ort_provider
+                      << " is not available in this ONNX Runtime build, skipping it." << std::endl;
+            continue;
+        }
+
+        try {
+            if (provider == "cuda") {
+                const OrtApi &api = Ort::GetApi();
+                OrtCUDAProviderOptionsV2 *cuda_options = nullptr;
+                Ort::ThrowOnError(api.CreateCUDAProviderOptions(&cuda_options));
+                std::unique_ptr<OrtCUDAProviderOptionsV2, decltype(api.ReleaseCUDAProviderOptions)>
+                        cuda_options_guard(cuda_options, api.ReleaseCUDAProviderOptions);
+
+                const char *keys[] = {"use_tf32"};
+                const char *values[] = {_enable_tf32 ? "1" : "0"};
+                Ort::ThrowOnError(api.UpdateCUDAProviderOptions(cuda_options, keys, values, 1));
+                _session_options.AppendExecutionProvider_CUDA_V2(*cuda_options);
+                provider_set = provider;
                 break;
             }
-            catch (const Ort::Exception& e) 
-            {
-                std::cerr << "ONNX Runtime error: " << e.what() << std::endl;
-                continue;
-            }  
+
+            OrtTensorRTProviderOptions trt_options;
+            trt_options.trt_fp16_enable = _enable_fp16 ? 1 : 0;
+            _session_options.AppendExecutionProvider_TensorRT(trt_options);
+            provider_set = provider;
+            break;
+        } catch (const Ort::Exception &e) {
+            std::cerr << "Warning: could not add the " << provider << " execution provider, skipping it. "
+                      << "ONNX Runtime error: " << e.what() << std::endl;
         }
     }
-          
-    // If neither CUDA nor TensorRT is available or suitable, fall back to CPU
-    if (!provider_set) {
-        _session_options = Ort::SessionOptions();
-        std::cout << "Using CPU execution provider." << std::endl;
-    }
+    std::cout << "Using " << provider_set << " execution provider." << std::endl;
 
     // Create session
     _session = std::make_unique<Ort::Session>(_env, model_path.c_str(), _session_options);
@@ -80,67 +105,275 @@ void ReIDModel::_initialize_onnx_session(const std::string &model_path) {
     
     _input_node_names.push_back(input_name_ptr.get());
     _output_node_names.push_back(output_name_ptr.get());
+    for (const std::string &name : _input_node_names) {
+        _input_names_char.push_back(name.c_str());
+    }
+    for (const std::string &name : _output_node_names) {
+        _output_names_char.push_back(name.c_str());
+    }
+    _memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
 
-    // Get input shape
+    // Get input shape (NCHW), dynamic axes are reported as -1
     auto input_shape = _session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
-    _input_tensor_shape = input_shape;
-    
-    // Allocate input tensor memory
-    size_t input_tensor_size = 1;
-    for (auto dim : input_shape) {
-        if (dim > 0) input_tensor_size *= dim;
+    if (input_shape.size() != 4) {
+        std::cout << "Invalid ReID model input of rank " << input_shape.size()
+                  << ". Only NCHW inputs are supported." << std::endl;
+        exit(1);
+    }
+
+    // The crop size comes from input_layer_dimensions, unless the model fixes it
+    if (input_shape[2] > 0 && input_shape[3] > 0) {
+        const cv::Size model_input_size(static_cast<int>(input_shape[3]),
+                                        static_cast<int>(input_shape[2]));
+        if (model_input_size != _input_size) {
+            std::cout << "ReID model input size " << model_input_size
+                      << " differs from input_layer_dimensions " << _input_size
+                      << ", using the model input size." << std::endl;
+            _input_size = model_input_size;
+        }
+    }
+
+    // The output holds FEATURE_DIM values per crop, e.g. [N, 512] or [N, 512, 1, 1].
+    // With dynamic feature axes, the output is bound as [N, FEATURE_DIM]
+    _output_tensor_shape = _session->GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    int64_t output_feature_dim = 1;
+    bool dynamic_output = _output_tensor_shape.empty();
+    for (size_t i = 1; i < _output_tensor_shape.size(); i++) {
+        dynamic_output = dynamic_output || _output_tensor_shape[i] <= 0;
+        output_feature_dim *= _output_tensor_shape[i];
+    }
+    if (dynamic_output) {
+        _output_tensor_shape = {-1, FEATURE_DIM};
+    } else if (output_feature_dim != FEATURE_DIM) {
+        std::cout << "Invalid ReID model output dimension " << output_feature_dim
+                  << ". Only " << FEATURE_DIM << " is supported." << std::endl;
+        exit(1);
+    }
+
+    // Models exported with a dynamic batch axis take up to batch_size crops per run,
+    // models with a fixed batch axis are always fed exactly that many crops
+    _dynamic_batch = input_shape[0] <= 0;
+    _max_batch_size = _dynamic_batch ? std::max(1, _batch_size)
+                                     : static_cast<int>(input_shape[0]);
+
+    // Inputs and outputs are bound to preallocated buffers, the output buffer is reused by every run
+    _io_binding = std::make_unique<Ort::IoBinding>(*_session);
+    _output_tensor_values.resize(static_cast<size_t>(_max_batch_size) * FEATURE_DIM);
+}
+
+
+FeatureVector ReIDModel::extract_features(const cv::Mat &image_patch) {
+    // The whole patch is one crop, resized straight into the input tensor
+    const cv::Rect_<float> patch_tlwh(0.0F, 0.0F, static_cast<float>(image_patch.cols),
+                                      static_cast<float>(image_patch.rows));
+    return extract_features(image_patch, {patch_tlwh}).row(0);
+}
+
+FeatureMatrix ReIDModel::extract_features(const cv::Mat &frame,
+                                          const std::vector<cv::Rect_<float>> &bboxes_tlwh) {
+    const int num_crops = static_cast<int>(bboxes_tlwh.size());
+    if (num_crops == 0) {
+        return FeatureMatrix(0, FEATURE_DIM);
     }
-    _input_tensor_values.resize(input_tensor_size);
+
+    _reserve_batch_tensor(num_crops);
+
+    // Preprocess all crops in parallel, each one into its own slot of the NCHW tensor
+    const size_t crop_size = 3 * static_cast<size_t>(_input_size.area());
+    cv::parallel_for_(cv::Range(0, num_crops), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            _pre_process_into(frame, bboxes_tlwh[i],
+                              _batch_tensor_values.data() + i * crop_size);
+        }
+    });
+
+    return _run_inference(num_crops);
 }
 
+FeatureMatrix ReIDModel::extract_features_batch(const std::vector<cv::Mat> &crops) {
+    const int num_crops = static_cast<int>(crops.size());
+    if (num_crops == 0) {
+        return FeatureMatrix(0, FEATURE_DIM);
+    }
 
-FeatureVector ReIDModel::extract_features(cv::Mat &image_patch) {
-    pre_process(image_patch);
-    
-    // Prepare input tensor
-    cv::Mat blob;
-    cv::dnn::blobFromImage(image_patch, blob, 1.0/255.0, _input_size, 
-                          cv::Scalar(0,0,0), _swap_rb, false);
-    
-    std::memcpy(_input_tensor_values.data(), blob.ptr<float>(), 
-                _input_tensor_values.size() * sizeof(float));
-
-    // Create input tensor
-    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-    auto input_tensor = Ort::Value::CreateTensor<float>(
-        memory_info, _input_tensor_values.data(), _input_tensor_values.size(),
-        _input_tensor_shape.data(), _input_tensor_shape.size());
-
-    std::vector<const char*> input_names_char(_input_node_names.size());
-    std::transform(_input_node_names.begin(), _input_node_names.end(), input_names_char.begin(),
-        [](const std::string& str) { return str.c_str(); });
-
-    std::vector<const char*> output_names_char(_output_node_names.size());
-    std::transform(_output_node_names.begin(), _output_node_names.end(), output_names_char.begin(),
-        [](const std::string& str) { return str.c_str(); });
-
-    // Run inference
-    auto output_tensors = _session->Run(
-        Ort::RunOptions{nullptr}, 
-        input_names_char.data(), 
-        &input_tensor, 
-        1, 
-        output_names_char.data(), 
-        1);
-
-    // Extract features
-    float* output_data = output_tensors[0].GetTensorMutableData<float>();
-    FeatureVector feature_vector = FeatureVector::Zero(1, FEATURE_DIM);
-    
-    for (int i = 0; i < FEATURE_DIM; i++) {
-        feature_vector(0, i) = output_data[i];
+    _reserve_batch_tensor(num_crops);
+
+    const size_t crop_size = 3 * static_cast<size_t>(_input_size.area());
+    cv::parallel_for_(cv::Range(0, num_crops), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            _pre_process_into(crops[i], _batch_tensor_values.data() + i * crop_size);
+        }
+    });
+
+    return _run_inference(num_crops);
+}
+
+void ReIDModel::_reserve_batch_tensor(int num_crops) {
+    const size_t crop_size = 3 * static_cast<size_t>(_input_size.area());
+    const int padded_crops = _dynamic_batch
+            ? num_crops
+            : (num_crops + _max_batch_size - 1) / _max_batch_size * _max_batch_size;
+    if (_batch_tensor_values.size() < padded_crops * crop_size) {
+        _batch_tensor_values.resize(padded_crops * crop_size);
+    }
+}
+
+FeatureMatrix ReIDModel::_run_inference(int num_crops) {
+    const size_t crop_size = 3 * static_cast<size_t>(_input_size.area());
+    FeatureMatrix features(num_crops, FEATURE_DIM);
+
+    for (int start = 0; start < num_crops; start += _max_batch_size) {
+        const int batch = std::min(_max_batch_size, num_crops - start);
+        const int64_t tensor_batch = _dynamic_batch ? batch : _max_batch_size;
+        std::array<int64_t, 4> input_shape = {tensor_batch, 3, _input_size.height,
+                                              _input_size.width};
+
+        // The tensor only wraps its chunk of the preallocated batch tensor
+        auto input_tensor = Ort::Value::CreateTensor<float>(
+            _memory_info, _batch_tensor_values.data() + start * crop_size,
+            tensor_batch * crop_size, input_shape.data(), input_shape.size());
+
+        _output_tensor_shape[0] = tensor_batch;
+        auto output_tensor = Ort::Value::CreateTensor<float>(
+            _memory_info, _output_tensor_values.data(), tensor_batch * FEATURE_DIM,
+            _output_tensor_shape.data(), _output_tensor_shape.size());
+
+        _io_binding->BindInput(_input_names_char[0], input_tensor);
+        _io_binding->BindOutput(_output_names_char[0], output_tensor);
+        _session->Run(Ort::RunOptions{nullptr}, *_io_binding);
+
+        features.middleRows(start, batch) =
+            Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, FEATURE_DIM, Eigen::RowMajor>>(
+                _output_tensor_values.data(), batch, FEATURE_DIM);
+    }
+
+    return features;
+}
+
+void ReIDModel::_pre_process_into(const cv::Mat &frame, const cv::Rect_<float> &bbox_tlwh,
+                                  float *tensor_slot) const {
+    // Same preprocessing as cv::dnn::blobFromImage: resize, optional BGR->RGB, scale to [0, 1], HWC->CHW
+    cv::Rect roi = cv::Rect(bbox_tlwh) & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (roi.empty()) {
+        std::fill(tensor_slot, tensor_slot + 3 * _input_size.area(), 0.0F);
+        return;
     }
 
-    return feature_vector;
+    if (frame.type() == CV_8UC3) {
+        _warp_into(frame, roi, tensor_slot);
+    } else {
+        _pre_process_into(frame(roi), tensor_slot);
+    }
+}
+
+void ReIDModel::_pre_process_into(const cv::Mat &crop, float *tensor_slot) const {
+    if (crop.type() == CV_8UC3) {
+        _warp_into(crop, cv::Rect(0, 0, crop.cols, crop.rows), tensor_slot);
+        return;
+    }
+
+    cv::Mat resized, resized_float;
+    cv::resize(crop, resized, _input_size);
+    resized.convertTo(resized_float, CV_32F, 1.0 / 255.0);
+
+    const int plane_size = _input_size.area();
+    std::vector<cv::Mat> planes = {
+        cv::Mat(_input_size, CV_32F, tensor_slot + (_swap_rb ? 2 : 0) * plane_size),
+        cv::Mat(_input_size, CV_32F, tensor_slot + plane_size),
+        cv::Mat(_input_size, CV_32F, tensor_slot + (_swap_rb ? 0 : 2) * plane_size)};
+    cv::split(resized_float, planes);
 }
 
-void ReIDModel::pre_process(cv::Mat &image) {
-    cv::resize(image, image, _input_size);
+void ReIDModel::_warp_into(const cv::Mat &image, const cv::Rect &roi,
+                           float *tensor_slot) const {
+    const int out_width = _input_size.width, out_height = _input_size.height;
+    const int plane_size = _input_size.area();
+    const float scale_x = static_cast<float>(roi.width) / out_width;
+    const float scale_y = static_cast<float>(roi.height) / out_height;
+    constexpr float normalization = 1.0F / 255.0F;
+
+    // Source channel c (BGR) goes to plane c, or 2 - c when swapping to RGB
+    float *planes[3] = {tensor_slot + (_swap_rb ? 2 : 0) * plane_size,
+                        tensor_slot + plane_size,
+                        tensor_slot + (_swap_rb ? 0 : 2) * plane_size};
+
+    // Bilinear taps with the pixel center convention of cv::resize, clamped at the border
+    auto tap = [](int i, float scale, int size, int &index, float &weight) {
+        float f = (static_cast<float>(i) + 0.5F) * scale - 0.5F;
+        index = static_cast<int>(std::floor(f));
+        weight = f - static_cast<float>(index);
+        if (index < 0) {
+            index = 0;
+            weight = 0.0F;
+        }
+        if (index >= size - 1) {
+            index = size - 1;
+            weight = 0.0F;
+        }
+    };
+
+    // The horizontal taps are the same for every row, computed once per crop
+    thread_local std::vector<int> x_offsets, x_steps;
+    thread_local std::vector<float> x_weights, rows;
+    x_offsets.resize(out_width);
+    x_steps.resize(out_width);
+    x_weights.resize(out_width);
+    rows.resize(2 * 3 * out_width);
+    for (int x = 0; x < out_width; x++) {
+        int sx;
+        tap(x, scale_x, roi.width, sx, x_weights[x]);
+        x_offsets[x] = (roi.x + sx) * 3;
+        x_steps[x] = sx < roi.width - 1 ? 3 : 0;
+    }
+
+    // Horizontal pass of one source row into a planar row buffer, already scaled to [0, 1].
+    // Local pointers: the uint8_t source could otherwise alias every store
+    const int *offsets = x_offsets.data(), *steps = x_steps.data();
+    const float *weights = x_weights.data();
+    auto interpolate_row = [&](int source_row, float *row_buffer) {
+        const uint8_t *source = image.ptr<uint8_t>(roi.y + source_row);
+        for (int x = 0; x < out_width; x++) {
+            const int a = offsets[x], b = a + steps[x];
+            const float wx = weights[x];
+            for (int c = 0; c < 3; c++) {
+                row_buffer[c * out_width + x] =
+                        (source[a + c] + wx * (source[b + c] - source[a + c])) * normalization;
+            }
+        }
+    };
+
+    // Consecutive output rows mostly share their source rows, which are interpolated once
+    float *row0 = rows.data(), *row1 = rows.data() + 3 * out_width;
+    int cached0 = -1, cached1 = -1;
+    for (int y = 0; y < out_height; y++) {
+        int sy;
+        float wy;
+        tap(y, scale_y, roi.height, sy, wy);
+        const int sy1 = std::min(sy + 1, roi.height - 1);
+
+        if (sy != cached0) {
+            if (sy == cached1) {
+                std::swap(row0, row1);
+                std::swap(cached0, cached1);
+            } else {
+                interpolate_row(sy, row0);
+                cached0 = sy;
+            }
+        }
+        if (sy1 != cached1) {
+            interpolate_row(sy1, row1);
+            cached1 = sy1;
+        }
+
+        // Vertical pass, contiguous in every plane
+        for (int c = 0; c < 3; c++) {
+            const float *top = row0 + c * out_width, *bottom = row1 + c * out_width;
+            float *out = planes[c] + y * out_width;
+            for (int x = 0; x < out_width; x++) {
+                out[x] = top[x] + wy * (bottom[x] - top[x]);
+            }
+        }
+    }
 }
 
 void ReIDModel::_load_params_from_config(const std::string &config_path) {
@@ -151,12 +384,83 @@ void ReIDModel::_load_params_from_config(const std::string &config_path) {
         exit(1);
     }
 
-    _distance_metric = reid_config.Get(section_name, "distance_metric", "euclidean");
-    _input_layer_name = reid_config.Get(section_name, "input_layer_name", "input");
+    const std::string distance_metric = reid_config.Get(section_name, "distance_metric", "euclidean");
+    if (distance_metric == "euclidean") {
+        _distance_metric = DistanceMetric::Euclidean;
+    } else if (distance_metric == "cosine") {
+        _distance_metric = DistanceMetric::Cosine;
+    } else {
+        std::cout << "Invalid distance metric " << distance_metric << " passed. "
+                  << "Only 'euclidean' and 'cosine' are supported." << std::endl;
+        exit(1);
+    }
+
     _swap_rb = reid_config.GetBoolean(section_name, "swapRB", false);
+    _batch_size = static_cast<int>(reid_config.GetInteger(section_name, "batch_size", 1));
 
+    // NCHW, the batch axis is given by batch_size
     std::vector<int> input_dims = reid_config.GetList<int>(section_name, "input_layer_dimensions");
+    if (input_dims.size() != 4) {
+        std::cout << "Invalid input_layer_dimensions passed. "
+                  << "Only NCHW dimensions, e.g. [1, 3, 256, 128], are supported." << std::endl;
+        exit(1);
+    }
     _input_size = cv::Size(input_dims[3], input_dims[2]);
+
+    std::vector<int> output_dims = reid_config.GetList<int>(section_name, "output_layer_dimensions");
+    if (output_dims.size() > 1 &&
+        std::accumulate(output_dims.begin() + 1, output_dims.end(), 1, std::multiplies<>()) !=
+                FEATURE_DIM) {
+        std::cout << "Invalid output_layer_dimensions passed. "
+                  << "The feature dimension must be " << FEATURE_DIM << "." << std::endl;
+        exit(1);
+    }
+
+    // ONNX Runtime session
+    _enable_fp16 = reid_config.GetBoolean(section_name, "enable_FP16", false);
+    _enable_tf32 = reid_config.GetBoolean(section_name, "enable_TF32", false);
+    _intra_op_num_threads = static_cast<int>(reid_config.GetInteger(section_name, "intra_op_num_threads", 1));
+    _inter_op_num_threads = static_cast<int>(reid_config.GetInteger(section_name, "inter_op_num_threads", 1));
+    _enable_cpu_mem_arena = reid_config.GetBoolean(section_name, "enable_cpu_mem_arena", true);
+    _enable_mem_pattern = reid_config.GetBoolean(section_name, "enable_mem_pattern", true);
+
+    const std::string execution_mode = reid_config.Get(section_name, "execution_mode", "sequential");
+    if (execution_mode == "sequential") {
+        _parallel_execution = false;
+    } else if (execution_mode == "parallel") {
+        _parallel_execution = true;
+    } else {
+        std::cout << "Invalid execution mode " << execution_mode << " passed. "
+                  << "Only 'sequential' and 'parallel' are supported." << std::endl;
+        exit(1);
+    }
+
+    const std::string optimization_level = reid_config.Get(section_name, "graph_optimization_level", "all");
+    if (optimization_level == "disable") {
+        _graph_optimization_level = GraphOptimizationLevel::ORT_DISABLE_ALL;
+    } else if (optimization_level == "basic") {
+        _graph_optimization_level = GraphOptimizationLevel::ORT_ENABLE_BASIC;
+    } else if (optimization_level == "extended") {
+        _graph_optimization_level = GraphOptimizationLevel::ORT_ENABLE_EXTENDED;
+    } else if (optimization_level == "all") {
+        _graph_optimization_level = GraphOptimizationLevel::ORT_ENABLE_ALL;
+    } else {
+        std::cout << "Invalid graph optimization level " << optimization_level << " passed. "
+                  << "Only 'disable', 'basic', 'extended' and 'all' are supported." << std::endl;
+        exit(1);
+    }
+
+    _execution_providers = reid_config.GetList<std::string>(section_name, "execution_providers");
+    if (_execution_providers.empty()) {
+        _execution_providers = {"tensorrt", "cuda", "cpu"};
+    }
+    for (const std::string &provider : _execution_providers) {
+        if (provider != "tensorrt" && provider != "cuda" && provider != "cpu") {
+            std::cout << "Invalid execution provider " << provider << " passed. "
+                      << "Only 'tensorrt', 'cuda' and 'cpu' are supported." << std::endl;
+            exit(1);
+        }
+    }
 }
 
 }
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "matching.h"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <numeric>
+
 #include "DataType.h"
 #include "utils.h"
 
@@ -25,10 +30,11 @@ iou_distance(const std::vector<std::shared_ptr<Track>> &tracks,
     {
         for (int i = 0; i < num_tracks; i++)
         {
+            const BBox &track_tlwh = tracks[i]->get_tlwh();
             for (int j = 0; j < num_detections; j++)
             {
-                cost_matrix(i, j) = 1.0F - iou(tracks[i]->get_tlwh(),
-                                               detections[j]->get_tlwh());
+                cost_matrix(i, j) =
+                        1.0F - iou(track_tlwh, detections[j]->get_tlwh());
 
                 if (cost_matrix(i, j) > max_iou_distance)
                 {
@@ -54,10 +60,11 @@ CostMatrix iou_distance(const std::vector<std::shared_ptr<Track>> &tracks,
     {
         for (int i = 0; i < num_tracks; i++)
         {
+            const BBox &track_tlwh = tracks[i]->get_tlwh();
             for (int j = 0; j < num_detections; j++)
             {
-                cost_matrix(i, j) = 1.0F - iou(tracks[i]->get_tlwh(),
-                                               detections[j]->get_tlwh());
+                cost_matrix(i, j) =
+                        1.0F - iou(track_tlwh, detections[j]->get_tlwh());
             }
         }
     }
@@ -65,179 +72,321 @@ CostMatrix iou_distance(const std::vector<std::shared_ptr<Track>> &tracks,
     return cost_matrix;
 }
 
-std::tuple<CostMatrix, CostMatrix>
-embedding_distance(const std::vector<std::shared_ptr<Track>> &tracks,
-                   const std::vector<std::shared_ptr<Track>> &detections,
-                   float max_embedding_distance,
-                   const std::string &distance_metric)
+using FeatureRows =
+        Eigen::Matrix<float, Eigen::Dynamic, FEATURE_DIM, Eigen::RowMajor>;
+
+/**
+ * @brief Stack the smoothed features of the tracks into contiguous rows, tracks without features get a row of zeros
+ */
+static void
+stack_track_features(const std::vector<std::shared_ptr<Track>> &tracks,
+                     FeatureRows &track_features)
 {
-    if (!(distance_metric == "euclidean" || distance_metric == "cosine"))
+    const auto num_tracks = static_cast<Eigen::Index>(tracks.size());
+
+    track_features.setZero(num_tracks, FEATURE_DIM);
+    for (Eigen::Index i = 0; i < num_tracks; i++)
     {
-        std::cout << "Invalid distance metric " << distance_metric
-                  << " passed.";
-        std::cout << "Only 'euclidean' and 'cosine' are supported."
-                  << std::endl;
-        exit(1);
+        if (tracks[i]->smooth_feat)
+        {
+            track_features.row(i) = *tracks[i]->smooth_feat;
+        }
     }
+}
 
-    size_t num_tracks = tracks.size();
-    size_t num_detections = detections.size();
+/**
+ * @brief Largest feature history among the tracks with features, 0 without gallery matching
+ */
+static Eigen::Index
+max_feature_history_size(const std::vector<std::shared_ptr<Track>> &tracks,
+                         bool gallery_matching)
+{
+    Eigen::Index max_size = 0;
+    for (const std::shared_ptr<Track> &track: tracks)
+    {
+        const FeatureGallery *history = track->get_feature_history();
+        if (gallery_matching && track->smooth_feat && history)
+        {
+            max_size = std::max(max_size,
+                                static_cast<Eigen::Index>(history->size()));
+        }
+    }
+    return max_size;
+}
 
-    CostMatrix cost_matrix =
-            Eigen::MatrixXf::Zero(static_cast<Eigen::Index>(num_tracks),
-                                  static_cast<Eigen::Index>(num_detections));
-    CostMatrix embedding_dists_mask =
-            Eigen::MatrixXf::Zero(static_cast<Eigen::Index>(num_tracks),
-                                  static_cast<Eigen::Index>(num_detections));
+/**
+ * @brief Stack the features of the detections into contiguous rows, detections without features get a row of zeros
+ */
+static void
+stack_detection_features(const std::vector<std::shared_ptr<Track>> &detections,
+                         FeatureRows &detection_features)
+{
+    const auto num_detections = static_cast<Eigen::Index>(detections.size());
 
-    if (num_tracks > 0 && num_detections > 0)
+    detection_features.setZero(num_detections, FEATURE_DIM);
+    for (Eigen::Index j = 0; j < num_detections; j++)
     {
-        for (int i = 0; i < num_tracks; i++)
+        if (detections[j]->curr_feat)
         {
-            for (int j = 0; j < num_detections; j++)
-            {
-                if (distance_metric == "euclidean")
-                    cost_matrix(i, j) = std::max(
-                            0.0f, euclidean_distance(tracks[i]->smooth_feat,
-                                                     detections[j]->curr_feat));
-                else
-                    cost_matrix(i, j) = std::max(
-                            0.0f, cosine_distance(tracks[i]->smooth_feat,
-                                                  detections[j]->curr_feat));
-
-                if (cost_matrix(i, j) > max_embedding_distance)
-                {
-                    embedding_dists_mask(i, j) = 1.0F;
-                }
-            }
+            detection_features.row(j) = *detections[j]->curr_feat;
         }
     }
+}
 
-    return {cost_matrix, embedding_dists_mask};
+/**
+ * @brief Convert the similarity (dot product) of two L2-normalized features into their distance.
+ *  Both distances decrease with the similarity, so the closest of several features is the most similar one.
+ */
+static inline float similarity_to_distance(float similarity,
+                                           DistanceMetric distance_metric)
+{
+    if (distance_metric == DistanceMetric::Euclidean)
+    {
+        // ||x - y||^2 = ||x||^2 + ||y||^2 - 2 x.y = 2 - 2 x.y
+        return std::sqrt(std::max(0.0F, 2.0F - 2.0F * similarity));
+    }
+    return 1.0F - similarity;
 }
 
-void fuse_score(CostMatrix &cost_matrix,
-                const std::vector<std::shared_ptr<Track>> &detections)
+/**
+ * @brief Compute the cosine similarities of the tracks [i0, i1) to the detections [j0, j1) into the top-left corner
+ *  of similarities. With gallery matching, a track is as similar as the closest of its smoothed feature and its
+ *  feature history, whose rows are multiplied in place rather than copied.
+ */
+static void
+track_similarities(const std::vector<std::shared_ptr<Track>> &tracks,
+                   const FeatureRows &track_features,
+                   const FeatureRows &detection_features, Eigen::Index i0,
+                   Eigen::Index i1, Eigen::Index j0, Eigen::Index j1,
+                   bool gallery_matching, Eigen::MatrixXf &similarities,
+                   Eigen::MatrixXf &history_similarities)
 {
-    if (cost_matrix.rows() == 0 || cost_matrix.cols() == 0)
+    const auto detection_rows = detection_features.middleRows(j0, j1 - j0);
+    auto tile = similarities.topLeftCorner(i1 - i0, j1 - j0);
+
+    // All the features are L2-normalized, so one matrix product gives every cosine similarity
+    tile.noalias() =
+            track_features.middleRows(i0, i1 - i0) * detection_rows.transpose();
+    if (!gallery_matching)
     {
         return;
     }
 
-    for (Eigen::Index i = 0; i < cost_matrix.rows(); i++)
+    for (Eigen::Index i = i0; i < i1; i++)
     {
-        for (Eigen::Index j = 0; j < cost_matrix.cols(); j++)
+        const FeatureGallery *history = tracks[i]->get_feature_history();
+        if (!tracks[i]->smooth_feat || !history || history->size() == 0)
         {
-            cost_matrix(i, j) = 1.0F - ((1.0F - cost_matrix(i, j)) *
-                                        detections[j]->get_score());
+            continue;
         }
+
+        const FeatureRowsView history_features = history->features();
+        auto history_tile = history_similarities.topLeftCorner(
+                history_features.rows(), j1 - j0);
+        history_tile.noalias() = history_features * detection_rows.transpose();
+        tile.row(i - i0) =
+                tile.row(i - i0).cwiseMax(history_tile.colwise().maxCoeff());
     }
 }
 
-void fuse_motion(const KalmanFilter &KF, CostMatrix &cost_matrix,
-                 const std::vector<std::shared_ptr<Track>> &tracks,
-                 const std::vector<std::shared_ptr<Track>> &detections,
-                 float lambda, bool only_position)
+std::tuple<CostMatrix, CostMatrix>
+embedding_distance(const std::vector<std::shared_ptr<Track>> &tracks,
+                   const std::vector<std::shared_ptr<Track>> &detections,
+                   float max_embedding_distance, DistanceMetric distance_metric,
+                   bool gallery_matching)
 {
-    if (cost_matrix.rows() == 0 || cost_matrix.cols() == 0)
-    {
-        return;
-    }
+    const auto num_tracks = static_cast<Eigen::Index>(tracks.size());
+    const auto num_detections = static_cast<Eigen::Index>(detections.size());
 
-    uint8_t gating_dim = only_position ? 2 : 4;
-    const double gating_threshold = KalmanFilter::chi2inv95[gating_dim];
+    // Features may be missing when ReID runs lazily, such pairs keep a cost of 1 and are masked, leaving them to IoU
+    CostMatrix cost_matrix = CostMatrix::Ones(num_tracks, num_detections);
+    CostMatrix embedding_dists_mask =
+            CostMatrix::Ones(num_tracks, num_detections);
 
-    std::vector<DetVec> measurements;
-    std::vector<float> det_xywh;
-    for (const std::shared_ptr<Track> &detection: detections)
+    if (num_tracks == 0 || num_detections == 0)
     {
-        DetVec det;
-
-        det_xywh = detection->get_tlwh();
-        det << det_xywh[0], det_xywh[1], det_xywh[2], det_xywh[3];
-        measurements.emplace_back(det);
+        return {cost_matrix, embedding_dists_mask};
     }
 
-    for (Eigen::Index i = 0; i < tracks.size(); i++)
+    FeatureRows track_features, detection_features;
+    stack_track_features(tracks, track_features);
+    stack_detection_features(detections, detection_features);
+
+    Eigen::MatrixXf similarities(num_tracks, num_detections);
+    Eigen::MatrixXf history_similarities(
+            max_feature_history_size(tracks, gallery_matching), num_detections);
+    track_similarities(tracks, track_features, detection_features, 0,
+                       num_tracks, 0, num_detections, gallery_matching,
+                       similarities, history_similarities);
+
+    for (Eigen::Index j = 0; j < num_detections; j++)
     {
-        Eigen::Matrix<float, 1, Eigen::Dynamic> gating_distance =
-                KF.gating_distance(tracks[i]->mean, tracks[i]->covariance,
-                                   measurements, only_position);
+        if (!detections[j]->curr_feat)
+        {
+            continue;
+        }
 
-        for (Eigen::Index j = 0; j < gating_distance.size(); j++)
+        for (Eigen::Index i = 0; i < num_tracks; i++)
         {
-            if (gating_distance(0, j) > gating_threshold)
+            if (!tracks[i]->smooth_feat)
             {
-                cost_matrix(i, j) = std::numeric_limits<float>::infinity();
+                continue;
             }
 
-            cost_matrix(i, j) = lambda * cost_matrix(i, j) +
-                                (1 - lambda) * gating_distance[j];
+            cost_matrix(i, j) = std::max(
+                    0.0f, similarity_to_distance(similarities(i, j),
+                                                 distance_metric));
+            embedding_dists_mask(i, j) =
+                    cost_matrix(i, j) > max_embedding_distance ? 1.0F : 0.0F;
         }
     }
+
+    return {cost_matrix, embedding_dists_mask};
 }
 
-CostMatrix fuse_iou_with_emb(CostMatrix &iou_dist, CostMatrix &emb_dist,
-                             const CostMatrix &iou_dists_mask,
-                             const CostMatrix &emb_dists_mask)
+CostMatrix fused_association_distance(
+        const std::vector<std::shared_ptr<Track>> &tracks,
+        const std::vector<std::shared_ptr<Track>> &detections,
+        float max_iou_distance, bool use_embedding,
+        float max_embedding_distance, DistanceMetric distance_metric,
+        float lambda, bool gallery_matching)
 {
+    const auto num_tracks = static_cast<Eigen::Index>(tracks.size());
+    const auto num_detections = static_cast<Eigen::Index>(detections.size());
 
-    if (emb_dist.rows() == 0 || emb_dist.cols() == 0)
+    CostMatrix cost_matrix(num_tracks, num_detections);
+    if (num_tracks == 0 || num_detections == 0)
     {
-        // Embedding distance is not available, mask off iou distance
-        for (Eigen::Index i = 0; i < iou_dist.rows(); i++)
-        {
-            for (Eigen::Index j = 0; j < iou_dist.cols(); j++)
-            {
-                if (static_cast<bool>(iou_dists_mask(i, j)))
-                {
-                    iou_dist(i, j) = 1.0F;
-                }
-            }
-        }
-        return iou_dist;
+        return cost_matrix;
     }
 
-    // If IoU distance is larger than threshold, don't use embedding at all
-    for (Eigen::Index i = 0; i < iou_dist.rows(); i++)
+    // Per-frame inputs are gathered once into contiguous buffers
+    FeatureRows track_features, detection_features;
+    KFMeasSpaceBatch measurements;
+    const auto gating_threshold =
+            static_cast<float>(MotionModel::chi2inv95[4]);
+    if (use_embedding)
     {
-        for (Eigen::Index j = 0; j < iou_dist.cols(); j++)
+        stack_track_features(tracks, track_features);
+        stack_detection_features(detections, detection_features);
+
+        measurements.resize(KALMAN_MEASUREMENT_SPACE_DIM, num_detections);
+        for (Eigen::Index j = 0; j < num_detections; j++)
         {
-            if (static_cast<bool>(iou_dists_mask(i, j)))
-            {
-                emb_dist(i, j) = 1.0F;
-            }
+            measurements.col(j) =
+                    Eigen::Vector4f::Map(detections[j]->get_tlwh().data());
         }
     }
 
-    // If emb distance is larger than threshold, set the emb distance to inf
-    for (Eigen::Index i = 0; i < emb_dist.rows(); i++)
+    // Scratch buffers for one tile, sized for the largest tile
+    constexpr Eigen::Index tile_size = 64;
+    const Eigen::Index max_tile_tracks = std::min(tile_size, num_tracks);
+    const Eigen::Index max_tile_detections = std::min(tile_size, num_detections);
+    Eigen::MatrixXf similarities(use_embedding ? max_tile_tracks : 0,
+                                 max_tile_detections);
+    Eigen::MatrixXf history_similarities(
+            use_embedding ? max_feature_history_size(tracks, gallery_matching)
+                          : 0,
+            max_tile_detections);
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+            gating_distances(use_embedding ? max_tile_tracks : 0,
+                             num_detections);
+
+    for (Eigen::Index i0 = 0; i0 < num_tracks; i0 += tile_size)
     {
-        for (Eigen::Index j = 0; j < emb_dist.cols(); j++)
+        const Eigen::Index i1 = std::min(i0 + tile_size, num_tracks);
+
+        // Motion gating of the tile tracks against all the detections
+        if (use_embedding)
         {
-            if (static_cast<bool>(emb_dists_mask(i, j)))
+            for (Eigen::Index i = i0; i < i1; i++)
             {
-                emb_dist(i, j) = 1.0F;
+                tracks[i]->motion_model().gating_distance(
+                        tracks[i]->mean, tracks[i]->covariance, measurements,
+                        gating_distances.row(i - i0));
             }
         }
-    }
 
-    // Fuse iou and emb distance by taking the element-wise minimum
-    CostMatrix cost_matrix =
-            Eigen::MatrixXf::Zero(iou_dist.rows(), iou_dist.cols());
-    for (Eigen::Index i = 0; i < iou_dist.rows(); i++)
-    {
-        for (Eigen::Index j = 0; j < iou_dist.cols(); j++)
+        for (Eigen::Index j0 = 0; j0 < num_detections; j0 += tile_size)
         {
-            cost_matrix(i, j) = std::min(iou_dist(i, j), emb_dist(i, j));
+            const Eigen::Index j1 = std::min(j0 + tile_size, num_detections);
+
+            // Feature similarities of the tile
+            if (use_embedding)
+            {
+                track_similarities(tracks, track_features, detection_features,
+                                   i0, i1, j0, j1, gallery_matching,
+                                   similarities, history_similarities);
+            }
+
+            for (Eigen::Index j = j0; j < j1; j++)
+            {
+                const BBox &detection_tlwh = detections[j]->get_tlwh();
+                const float detection_score = detections[j]->get_score();
+                const bool detection_has_feature =
+                        detections[j]->curr_feat != nullptr;
+
+                for (Eigen::Index i = i0; i < i1; i++)
+                {
+                    // IoU distance, fused with the detection score
+                    const float iou_dist =
+                            1.0F - iou(tracks[i]->get_tlwh(), detection_tlwh);
+                    const bool iou_masked = iou_dist > max_iou_distance;
+                    const float score_fused_iou_dist =
+                            1.0F - (1.0F - iou_dist) * detection_score;
+
+                    if (!use_embedding)
+                    {
+                        cost_matrix(i, j) =
+                                iou_masked ? 1.0F : score_fused_iou_dist;
+                        continue;
+                    }
+
+                    // Embedding distance, fused with the motion gating distance. Pairs outside the IoU gate,
+                    // beyond the appearance threshold or without features fall back to a distance of 1
+                    float emb_dist = 1.0F;
+                    if (!iou_masked && detection_has_feature &&
+                        tracks[i]->smooth_feat)
+                    {
+                        const float raw_emb_dist = std::max(
+                                0.0f, similarity_to_distance(
+                                              similarities(i - i0, j - j0),
+                                              distance_metric));
+                        if (raw_emb_dist <= max_embedding_distance)
+                        {
+                            const float gating_distance =
+                                    gating_distances(i - i0, j);
+                            emb_dist = gating_distance > gating_threshold
+                                               ? std::numeric_limits<
+                                                         float>::infinity()
+                                               : lambda * raw_emb_dist +
+                                                         (1 - lambda) *
+                                                                 gating_distance;
+                        }
+                    }
+
+                    cost_matrix(i, j) = std::min(score_fused_iou_dist, emb_dist);
+                }
+            }
         }
     }
 
     return cost_matrix;
 }
 
-AssociationData linear_assignment(CostMatrix &cost_matrix, float thresh)
+AssociationData linear_assignment(CostMatrix &cost_matrix, float thresh,
+                                  ThreadPool *thread_pool,
+                                  AssignmentWorkspace *workspace,
+                                  const AssignmentOptions &options,
+                                  AssignmentDuals *duals)
 {
+    const auto start_time = std::chrono::steady_clock::now();
+    auto elapsed_us = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - since)
+                .count();
+    };
+
     // If cost matrix is empty, all the tracks and detections are unmatched
     AssociationData associations;
 
@@ -253,13 +402,274 @@ AssociationData linear_assignment(CostMatrix &cost_matrix, float thresh)
             associations.unmatched_det_indices.emplace_back(i);
         }
 
+        if (duals)
+        {
+            duals->row_duals.assign(cost_matrix.rows(), 0.0F);
+            duals->col_duals.assign(cost_matrix.cols(), 0.0F);
+        }
         return associations;
     }
 
-    std::vector<int> rowsol, colsol;
-    double total_cost = lapjv(cost_matrix, rowsol, colsol, true, thresh);
+    const auto num_rows = static_cast<int>(cost_matrix.rows());
+    const auto num_cols = static_cast<int>(cost_matrix.cols());
+
+    // Pairs above the threshold are never matched, so the problem splits into the connected components of the
+    // feasible-pair graph. Union-find over its nodes: rows are [0, num_rows), columns are [num_rows, num_rows + num_cols)
+    std::vector<int> parent(num_rows + num_cols);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find_root = [&parent](int node) {
+        while (parent[node] != node)
+        {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    };
+
+    for (int j = 0; j < num_cols; j++)
+    {
+        for (int i = 0; i < num_rows; i++)
+        {
+            if (cost_matrix(i, j) <= thresh)
+            {
+                parent[find_root(i)] = find_root(num_rows + j);
+            }
+        }
+    }
+
+    // Rows and columns of every component, isolated rows and columns end up in components without any pair
+    struct Component
+    {
+        std::vector<int> rows, cols;
+    };
+    std::vector<Component> components;
+    std::vector<int> component_of_root(num_rows + num_cols, -1);
+    for (int node = 0; node < num_rows + num_cols; node++)
+    {
+        int &component_idx = component_of_root[find_root(node)];
+        if (component_idx < 0)
+        {
+            component_idx = static_cast<int>(components.size());
+            components.emplace_back();
+        }
+
+        if (node < num_rows)
+            components[component_idx].rows.push_back(node);
+        else
+            components[component_idx].cols.push_back(node - num_rows);
+    }
+
+    // Warm start of the exact solver: the seeds and duals of the caller, split into the components below.
+    // The duals of the pairs not solved as a LAP are those of a single-pair assignment
+    const bool warm_start =
+            duals && duals->row_seeds.size() == static_cast<size_t>(num_rows) &&
+            duals->row_duals.size() == static_cast<size_t>(num_rows) &&
+            duals->col_duals.size() == static_cast<size_t>(num_cols) &&
+            (options.solver == AssignmentSolver::LAPJV ||
+             options.solver == AssignmentSolver::Budgeted);
+    std::vector<float> row_duals, col_duals;
+    std::vector<int> local_col(warm_start ? num_cols : 0);
+    if (duals)
+    {
+        if (warm_start)
+        {
+            row_duals.swap(duals->row_duals);
+            col_duals.swap(duals->col_duals);
+            for (const Component &component: components)
+            {
+                for (size_t c = 0; c < component.cols.size(); c++)
+                {
+                    local_col[component.cols[c]] = static_cast<int>(c);
+                }
+            }
+        }
+        duals->row_duals.assign(num_rows, 0.0F);
+        duals->col_duals.assign(num_cols, 0.0F);
+    }
+
+    std::vector<int> rowsol(num_rows, -1), colsol(num_cols, -1);
+    std::vector<const Component *> lap_components;
+    for (const Component &component: components)
+    {
+        if (component.rows.empty() || component.cols.empty())
+        {
+            continue;
+        }
+
+        if (component.rows.size() > 1 && component.cols.size() > 1)
+        {
+            lap_components.push_back(&component);
+            continue;
+        }
+
+        // A single track or a single detection: every pair of the component is feasible, take the cheapest one
+        int best_row = component.rows[0], best_col = component.cols[0];
+        for (int row: component.rows)
+        {
+            for (int col: component.cols)
+            {
+                if (cost_matrix(row, col) < cost_matrix(best_row, best_col))
+                {
+                    best_row = row, best_col = col;
+                }
+            }
+        }
+        rowsol[best_row] = best_col;
+        colsol[best_col] = best_row;
+        if (duals)
+        {
+            duals->row_duals[best_row] = cost_matrix(best_row, best_col);
+        }
+    }
+
+    // The remaining components are independent LAPs, each one writes to its own rows and columns of the solution.
+    // Components are dealt round-robin to the solvers, each solver reuses its own workspace
+    auto solve_component = [&](const Component *component,
+                               AssignmentWorkspace::Solver &solver) {
+        CostMatrix &component_cost = solver.component_cost;
+        component_cost.resize(static_cast<Eigen::Index>(component->rows.size()),
+                              static_cast<Eigen::Index>(component->cols.size()));
+        for (Eigen::Index c = 0; c < component_cost.cols(); c++)
+        {
+            for (Eigen::Index r = 0; r < component_cost.rows(); r++)
+            {
+                component_cost(r, c) =
+                        cost_matrix(component->rows[r], component->cols[c]);
+            }
+        }
+
+        // Seeds of the component, in its local indices. A seed outside of the component is infeasible
+        AssignmentDuals *component_duals = nullptr;
+        if (duals)
+        {
+            component_duals = &solver.duals;
+            component_duals->row_duals.assign(component->rows.size(), 0.0F);
+            component_duals->col_duals.assign(component->cols.size(), 0.0F);
+            component_duals->row_seeds.clear();
+            if (warm_start)
+            {
+                component_duals->row_seeds.assign(component->rows.size(), -1);
+                for (size_t r = 0; r < component->rows.size(); r++)
+                {
+                    const int row = component->rows[r];
+                    const int seed = duals->row_seeds[row];
+                    if (seed >= 0 && seed < num_cols &&
+                        local_col[seed] < static_cast<int>(component->cols.size()) &&
+                        component->cols[local_col[seed]] == seed)
+                    {
+                        component_duals->row_seeds[r] = local_col[seed];
+                    }
+                    component_duals->row_duals[r] = row_duals[row];
+                }
+                for (size_t c = 0; c < component->cols.size(); c++)
+                {
+                    component_duals->col_duals[c] = col_duals[component->cols[c]];
+                }
+            }
+        }
+
+        const auto n_component_rows = static_cast<uint_t>(component->rows.size());
+        const auto n_component_cols = static_cast<uint_t>(component->cols.size());
+        switch (options.solver)
+        {
+            case AssignmentSolver::Auction:
+                auction(component_cost, solver.rowsol, solver.colsol,
+                        solver.lapjv, thresh, options.auction_epsilon,
+                        thread_pool, false);
+                break;
+            case AssignmentSolver::Greedy:
+                greedy(component_cost, solver.rowsol, solver.colsol,
+                       solver.lapjv, thresh, false);
+                break;
+            case AssignmentSolver::Budgeted:
+                if (solver.time_model.fall_back(
+                            n_component_rows, n_component_cols,
+                            options.time_budget_us - elapsed_us(start_time)))
+                {
+                    greedy(component_cost, solver.rowsol, solver.colsol,
+                           solver.lapjv, thresh, false);
+                }
+                else
+                {
+                    const auto solve_start = std::chrono::steady_clock::now();
+                    lapjv(component_cost, solver.rowsol, solver.colsol,
+                          solver.lapjv, true, thresh, false, component_duals);
+                    solver.time_model.update(n_component_rows, n_component_cols,
+                                             elapsed_us(solve_start));
+                }
+                break;
+            default:
+                lapjv(component_cost, solver.rowsol, solver.colsol, solver.lapjv,
+                      true, thresh, false, component_duals);
+                break;
+        }
+
+        if (duals && component_duals)
+        {
+            for (size_t r = 0; r < component->rows.size(); r++)
+            {
+                duals->row_duals[component->rows[r]] = component_duals->row_duals[r];
+            }
+            for (size_t c = 0; c < component->cols.size(); c++)
+            {
+                duals->col_duals[component->cols[c]] = component_duals->col_duals[c];
+            }
+        }
+
+        for (size_t r = 0; r < solver.rowsol.size(); r++)
+        {
+            if (solver.rowsol[r] >= 0)
+            {
+                const int row = component->rows[r];
+                const int col = component->cols[solver.rowsol[r]];
+                rowsol[row] = col;
+                colsol[col] = row;
+            }
+        }
+    };
+
+    AssignmentWorkspace local_workspace;
+    if (!workspace)
+    {
+        workspace = &local_workspace;
+    }
+
+    // The auction parallelizes its own bids, its components are solved on the calling thread only
+    const bool parallel_components =
+            thread_pool && options.solver != AssignmentSolver::Auction;
+    const size_t num_solvers = std::min<size_t>(
+            lap_components.size(),
+            parallel_components ? thread_pool->size() + 1 : 1);
+    if (workspace->solvers.size() < num_solvers)
+    {
+        workspace->solvers.resize(num_solvers);
+    }
 
-    for (int i = 0; i < rowsol.size(); i++)
+    auto run_solver = [&](size_t solver_idx) {
+        for (size_t c = solver_idx; c < lap_components.size();
+             c += num_solvers)
+        {
+            solve_component(lap_components[c],
+                            workspace->solvers[solver_idx]);
+        }
+    };
+
+    std::vector<std::future<void>> pending;
+    for (size_t solver_idx = 1; solver_idx < num_solvers; solver_idx++)
+    {
+        pending.push_back(thread_pool->submit(
+                [&, solver_idx]() { run_solver(solver_idx); }));
+    }
+    if (num_solvers > 0)
+    {
+        run_solver(0);
+    }
+    for (std::future<void> &result: pending)
+    {
+        result.get();
+    }
+
+    for (int i = 0; i < num_rows; i++)
     {
         if (rowsol[i] >= 0)
         {
@@ -271,14 +681,77 @@ AssociationData linear_assignment(CostMatrix &cost_matrix, float thresh)
         }
     }
 
-    for (int i = 0; i < colsol.size(); i++)
+    for (int j = 0; j < num_cols; j++)
     {
-        if (colsol[i] < 0)
+        if (colsol[j] < 0)
         {
-            associations.unmatched_det_indices.emplace_back(i);
+            associations.unmatched_det_indices.emplace_back(j);
         }
     }
 
     return associations;
 }
+
+AssignmentDuals *
+AssociationWarmStart::seed(const std::vector<std::shared_ptr<Track>> &tracks,
+                           const std::vector<std::shared_ptr<Track>> &detections)
+{
+    _duals.row_seeds.assign(tracks.size(), -1);
+    _duals.row_duals.assign(tracks.size(), 0.0F);
+    _duals.col_duals.assign(detections.size(), 0.0F);
+    _seeded_detections.assign(detections.size(), false);
+
+    for (size_t i = 0; i < tracks.size(); i++)
+    {
+        auto entry = _entries.find(tracks[i]->track_id);
+        if (entry == _entries.end())
+        {
+            continue;
+        }
+
+        // The detection closest to the previous one, if no other track was seeded with it
+        int best_detection = -1;
+        float best_iou = min_seed_iou;
+        for (size_t j = 0; j < detections.size(); j++)
+        {
+            const float overlap = iou(entry->second.detection_tlwh,
+                                      detections[j]->get_tlwh());
+            if (overlap >= best_iou && !_seeded_detections[j])
+            {
+                best_iou = overlap;
+                best_detection = static_cast<int>(j);
+            }
+        }
+
+        if (best_detection >= 0)
+        {
+            _seeded_detections[best_detection] = true;
+            _duals.row_seeds[i] = best_detection;
+            _duals.row_duals[i] = entry->second.track_dual;
+            _duals.col_duals[best_detection] = entry->second.detection_dual;
+        }
+    }
+
+    return &_duals;
+}
+
+void AssociationWarmStart::update(
+        const std::vector<std::shared_ptr<Track>> &tracks,
+        const std::vector<std::shared_ptr<Track>> &detections,
+        const AssociationData &associations)
+{
+    _entries.clear();
+    if (_duals.row_duals.size() != tracks.size() ||
+        _duals.col_duals.size() != detections.size())
+    {
+        return;
+    }
+
+    for (const std::pair<int, int> &match: associations.matches)
+    {
+        _entries[tracks[match.first]->track_id] = {
+                detections[match.second]->get_tlwh(),
+                _duals.row_duals[match.first], _duals.col_duals[match.second]};
+    }
+}
 }
@@ -8,66 +8,77 @@ namespace botsort
 {
 
 
-Track::Track(std::vector<float> tlwh, float score, uint8_t class_id,
-             std::optional<FeatureVector> feat, int feat_history_size)
-    : det_tlwh(std::move(tlwh)), _score(score), _class_id(class_id),
-      tracklet_len(0), is_activated(false), state(TrackState::New)
+Track::Track(const BBox &tlwh, float score, uint8_t class_id,
+             std::optional<FeatureVector> feat,
+             std::shared_ptr<EmbeddingArena> embedding_arena)
+    : det_tlwh(tlwh), _score(score), _class_id(class_id),
+      tracklet_len(0), is_activated(false), state(TrackState::New),
+      _state_frame_id(0), _feature_frame_id(0),
+      _embedding_arena(std::move(embedding_arena))
 {
 
     if (feat)
     {
-        _feat_history_size = feat_history_size;
         _update_features(std::make_shared<FeatureVector>(feat.value()));
     }
     else
     {
         curr_feat = nullptr;
         smooth_feat = nullptr;
-        _feat_history_size = 0;
     }
 
     _update_class_id(class_id, score);
     _update_tracklet_tlwh_inplace();
 }
 
-void Track::activate(KalmanFilter &kalman_filter, uint32_t frame_id)
+void Track::activate(std::shared_ptr<const MotionModel> motion_model,
+                     uint32_t frame_id, std::optional<int> recovered_id)
 {
-    track_id = next_id();
+    _motion_model = std::move(motion_model);
+    track_id = recovered_id ? *recovered_id : next_id();
 
     // Create DetVec from det_tlwh
     DetVec detection_bbox;
     _populate_DetVec_xywh(detection_bbox, det_tlwh);
 
     // Initialize the Kalman filter matrices
-    KFDataStateSpace state_space = kalman_filter.init(detection_bbox);
+    KFDataStateSpace state_space = _motion_model->init(detection_bbox);
     mean = state_space.first;
     covariance = state_space.second;
 
-    if (frame_id == 1)
+    if (frame_id == 1 || recovered_id)
     {
         is_activated = true;
     }
     this->frame_id = frame_id;
+    _state_frame_id = frame_id;
     start_frame = frame_id;
     state = TrackState::Tracked;
     tracklet_len = 1;
     _update_tracklet_tlwh_inplace();
+
+    // The feature history only starts once the detection becomes a track
+    if (curr_feat)
+    {
+        _push_feature_history(*curr_feat);
+        _feature_frame_id = frame_id;
+    }
 }
 
-void Track::re_activate(KalmanFilter &kalman_filter, Track &new_track,
-                        uint32_t frame_id, bool new_id)
+void Track::re_activate(Track &new_track, uint32_t frame_id, bool new_id)
 {
     DetVec new_track_bbox;
     _populate_DetVec_xywh(new_track_bbox, new_track._tlwh);
 
     KFDataStateSpace state_space =
-            kalman_filter.update(mean, covariance, new_track_bbox);
+            _motion_model->update(mean, covariance, new_track_bbox);
     mean = state_space.first;
     covariance = state_space.second;
 
     if (new_track.curr_feat)
     {
         _update_features(new_track.curr_feat);
+        _feature_frame_id = frame_id;
     }
 
     if (new_id)
@@ -80,65 +91,97 @@ void Track::re_activate(KalmanFilter &kalman_filter, Track &new_track,
     is_activated = true;
     _score = new_track._score;
     this->frame_id = frame_id;
+    _state_frame_id = frame_id;
 
     _update_class_id(new_track._class_id, new_track._score);
     _update_tracklet_tlwh_inplace();
 }
 
-void Track::predict(KalmanFilter &kalman_filter)
+void Track::predict()
 {
     // If the track is not tracked, set the velocity for w and h to 0
     if (state != TrackState::Tracked)
         mean(6) = 0, mean(7) = 0;
 
-    kalman_filter.predict(mean, covariance);
+    // A tracked track was updated in the previous frame, so its tracklet length counts consecutive updates
+    if (state == TrackState::Tracked &&
+        _motion_model->in_steady_state(tracklet_len))
+        _motion_model->predict_steady_state(mean, covariance);
+    else
+        _motion_model->predict(mean, covariance);
+    _state_frame_id++;
     _update_tracklet_tlwh_inplace();
 }
 
-void Track::multi_predict(std::vector<std::shared_ptr<Track>> &tracks,
-                          KalmanFilter &kalman_filter)
+void Track::predict_to(uint32_t frame_id)
 {
-    for (std::shared_ptr<Track> &track: tracks)
+    if (frame_id <= _state_frame_id)
     {
-        track->predict(kalman_filter);
+        return;
     }
-}
 
-void Track::apply_camera_motion(const HomographyMatrix &H)
-{
-    Eigen::MatrixXf R = H.block(0, 0, 2, 2);
-    Eigen::VectorXf t = H.block(0, 2, 2, 1);
+    // The track is not tracked, so its size is kept constant
+    mean(6) = 0, mean(7) = 0;
 
-    Eigen::Matrix<float, 8, 8> R8x8 = Eigen::Matrix<float, 8, 8>::Identity();
-    R8x8.block(0, 0, 2, 2) = R;
+    _motion_model->predict(mean, covariance,
+                           static_cast<int>(frame_id - _state_frame_id));
+    _state_frame_id = frame_id;
+    _update_tracklet_tlwh_inplace();
+}
 
-    mean = R8x8 * mean.transpose();
-    mean.head(2) += t;
-    covariance = R8x8 * covariance * R8x8.transpose();
+void Track::multi_predict(std::vector<std::shared_ptr<Track>> &tracks)
+{
+    for (std::shared_ptr<Track> &track: tracks)
+    {
+        track->predict();
+    }
 }
 
 void Track::multi_gmc(std::vector<std::shared_ptr<Track>> &tracks,
                       const HomographyMatrix &H)
 {
+    // GMC returns the identity when the camera motion could not be estimated
+    if (tracks.empty() || H == HomographyMatrix::Identity())
+    {
+        return;
+    }
+
+    const Eigen::Matrix2f R = H.topLeftCorner<2, 2>();
+    const Eigen::Vector2f t = H.topRightCorner<2, 1>();
     for (std::shared_ptr<Track> &track: tracks)
     {
-        track->apply_camera_motion(H);
+        track->_apply_camera_motion(R, t);
     }
 }
 
-void Track::update(KalmanFilter &kalman_filter, Track &new_track,
-                   uint32_t frame_id)
+void Track::_apply_camera_motion(const Eigen::Matrix2f &R,
+                                 const Eigen::Vector2f &t)
+{
+    // Only the center is transformed: with R8 = [R, 0; 0, I],
+    //   R8 * covariance * R8^T multiplies the first two rows by R and the first two columns by R^T
+    mean.head<2>() = (R * mean.head<2>().transpose() + t).transpose();
+    covariance.topRows<2>() = R * covariance.topRows<2>();
+    covariance.leftCols<2>() = covariance.leftCols<2>() * R.transpose();
+}
+
+void Track::update(Track &new_track, uint32_t frame_id)
 {
 
     DetVec new_track_bbox;
     _populate_DetVec_xywh(new_track_bbox, new_track._tlwh);
 
+    // Same condition as in predict(), the track was predicted with the steady-state covariance
     KFDataStateSpace state_space =
-            kalman_filter.update(mean, covariance, new_track_bbox);
+            state == TrackState::Tracked &&
+                            _motion_model->in_steady_state(tracklet_len)
+                    ? _motion_model->update_steady_state(mean, covariance,
+                                                         new_track_bbox)
+                    : _motion_model->update(mean, covariance, new_track_bbox);
 
     if (new_track.curr_feat)
     {
         _update_features(new_track.curr_feat);
+        _feature_frame_id = frame_id;
     }
 
     mean = state_space.first;
@@ -148,18 +191,29 @@ void Track::update(KalmanFilter &kalman_filter, Track &new_track,
     _score = new_track._score;
     tracklet_len++;
     this->frame_id = frame_id;
+    _state_frame_id = frame_id;
 
     _update_class_id(new_track._class_id, new_track._score);
     _update_tracklet_tlwh_inplace();
 }
 
+void Track::set_features(const FeatureVector &feat)
+{
+    _update_features(std::make_shared<FeatureVector>(feat));
+}
+
+const FeatureGallery *Track::get_feature_history() const
+{
+    return _feat_history.get();
+}
+
 void Track::_update_features(const std::shared_ptr<FeatureVector> &feat)
 {
     *feat /= feat->norm();
 
-    if (_feat_history.empty())
+    curr_feat = feat;
+    if (!smooth_feat)
     {
-        curr_feat = feat;
         smooth_feat = std::make_unique<FeatureVector>(*curr_feat);
     }
     else
@@ -167,14 +221,28 @@ void Track::_update_features(const std::shared_ptr<FeatureVector> &feat)
         *smooth_feat = _alpha * (*smooth_feat) + (1 - _alpha) * (*feat);
     }
 
-    if (_feat_history.size() == _feat_history_size)
+    // Detections keep only their current feature, the history is recorded from activation on
+    if (state != TrackState::New)
     {
-        _feat_history.pop_front();
+        _push_feature_history(*curr_feat);
     }
-    _feat_history.push_back(curr_feat);
     *smooth_feat /= smooth_feat->norm();
 }
 
+void Track::_push_feature_history(const FeatureVector &feat)
+{
+    if (!_embedding_arena)
+    {
+        return;
+    }
+
+    if (!_feat_history)
+    {
+        _feat_history = _embedding_arena->acquire();
+    }
+    _feat_history->push(feat);
+}
+
 int Track::next_id()
 {
     static int _count = 0;
@@ -202,8 +270,12 @@ uint32_t Track::end_frame() const
     return frame_id;
 }
 
-void Track::_populate_DetVec_xywh(DetVec &bbox_xywh,
-                                  const std::vector<float> &tlwh)
+uint32_t Track::feature_frame() const
+{
+    return _feature_frame_id;
+}
+
+void Track::_populate_DetVec_xywh(DetVec &bbox_xywh, const BBox &tlwh)
 {
     bbox_xywh << tlwh[0] + tlwh[2] / 2, tlwh[1] + tlwh[3] / 2, tlwh[2], tlwh[3];
 }
@@ -222,7 +294,7 @@ void Track::_update_tracklet_tlwh_inplace()
     _tlwh = {mean(0) - mean(2) / 2, mean(1) - mean(3) / 2, mean(2), mean(3)};
 }
 
-std::vector<float> Track::get_tlwh() const
+const BBox &Track::get_tlwh() const
 {
     return _tlwh;
 }
@@ -232,6 +304,11 @@ float Track::get_score() const
     return _score;
 }
 
+uint8_t Track::get_class_id() const
+{
+    return _class_id;
+}
+
 void Track::_update_class_id(uint8_t class_id, float score)
 {
     if (!_class_hist.empty())
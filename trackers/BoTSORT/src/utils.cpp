@@ -1,154 +1,234 @@
 #include "utils.h"
 
-#include <iostream>
-
-#include "lapjv.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 
 namespace botsort
 {
 
-double lapjv(CostMatrix &cost, std::vector<int> &rowsol,
-             std::vector<int> &colsol, bool extend_cost, float cost_limit,
-             bool return_cost)
+/**
+ * @brief Row-major cost matrix of the problem seen by a rectangular solver. The column-major CostMatrix is already
+ *  the row-major transposed problem, which is used in place, otherwise the matrix is copied to the workspace.
+ */
+static const float *row_major_cost(const CostMatrix &cost,
+                                   LapjvWorkspace &workspace, bool transpose)
 {
-    std::vector<std::vector<float>> cost_c;
-
-    for (Eigen::Index i = 0; i < cost.rows(); i++)
+    if (transpose)
     {
-        std::vector<float> row;
-        for (Eigen::Index j = 0; j < cost.cols(); j++)
-        {
-            row.push_back(cost(i, j));
-        }
-        cost_c.push_back(row);
+        return cost.data();
     }
 
-    std::vector<std::vector<float>> cost_c_extended;
+    const int n_rows = static_cast<int>(cost.rows());
+    const int n_cols = static_cast<int>(cost.cols());
+    const size_t stride = static_cast<size_t>(n_cols);
+    workspace.cost.resize(static_cast<size_t>(n_rows) * stride);
+    float *cost_c = workspace.cost.data();
+    for (int j = 0; j < n_cols; j++)
+    {
+        const float *cost_j = cost.col(j).data();
+        for (int i = 0; i < n_rows; i++) { cost_c[i * stride + j] = cost_j[i]; }
+    }
+    return cost_c;
+}
 
-    int n_rows = static_cast<int>(cost.rows());
-    int n_cols = static_cast<int>(cost.cols());
-    rowsol.resize(n_rows);
-    colsol.resize(n_cols);
+/**
+ * @brief Copy the solution of the solver to rowsol and colsol, and compute its total cost
+ */
+static double collect_solution(const CostMatrix &cost, const int_t *x_c,
+                               const int_t *y_c, std::vector<int> &rowsol,
+                               std::vector<int> &colsol, bool return_cost)
+{
+    const int n_rows = static_cast<int>(cost.rows());
+    const int n_cols = static_cast<int>(cost.cols());
 
-    int n = 0;
-    if (n_rows == n_cols) { n = n_rows; }
-    else
+    double opt = 0.0;
+    for (int i = 0; i < n_rows; i++)
     {
-        if (!extend_cost)
+        if (x_c[i] >= 0 && x_c[i] < n_cols)
         {
-            std::cout << "set extend_cost=True" << std::endl;
-            exit(0);
+            rowsol[i] = x_c[i];
+            if (return_cost) { opt += cost(i, x_c[i]); }
         }
     }
+    for (int j = 0; j < n_cols; j++)
+    {
+        if (y_c[j] >= 0 && y_c[j] < n_rows) { colsol[j] = y_c[j]; }
+    }
+
+    return opt;
+}
 
-    if (extend_cost || cost_limit < LONG_MAX)
+double lapjv(const CostMatrix &cost, std::vector<int> &rowsol,
+             std::vector<int> &colsol, LapjvWorkspace &workspace,
+             bool extend_cost, float cost_limit, bool return_cost,
+             AssignmentDuals *duals)
+{
+    const int n_rows = static_cast<int>(cost.rows());
+    const int n_cols = static_cast<int>(cost.cols());
+    rowsol.assign(n_rows, -1);
+    colsol.assign(n_cols, -1);
+
+    const bool limit_cost = cost_limit < std::numeric_limits<float>::max();
+    if (n_rows != n_cols && !extend_cost)
+    {
+        throw std::runtime_error(
+                "lapjv: rectangular cost matrix requires extend_cost=true");
+    }
+    if (n_rows == 0 || n_cols == 0)
     {
-        n = n_rows + n_cols;
-        cost_c_extended.resize(n);
-        for (int i = 0; i < cost_c_extended.size(); i++)
-            cost_c_extended[i].resize(n);
+        return 0.0;
+    }
 
-        if (cost_limit < LONG_MAX)
-        {
-            for (int i = 0; i < cost_c_extended.size(); i++)
-            {
-                for (int j = 0; j < cost_c_extended[i].size(); j++)
-                {
-                    cost_c_extended[i][j] = cost_limit / 2.0;
-                }
-            }
-        }
-        else
+    if (n_rows == n_cols && !limit_cost && !duals)
+    {
+        // Square problem, every row is assigned
+        const float *cost_c = row_major_cost(cost, workspace, false);
+        workspace.x.resize(n_rows);
+        workspace.y.resize(n_cols);
+        if (lapjv_internal<float>(n_rows, cost_c, workspace.x.data(),
+                                  workspace.y.data(), workspace.buffers) != 0)
         {
-            float cost_max = -1;
-            for (int i = 0; i < cost_c.size(); i++)
-            {
-                for (int j = 0; j < cost_c[i].size(); j++)
-                {
-                    if (cost_c[i][j] > cost_max) cost_max = cost_c[i][j];
-                }
-            }
-            for (int i = 0; i < cost_c_extended.size(); i++)
-            {
-                for (int j = 0; j < cost_c_extended[i].size(); j++)
-                {
-                    cost_c_extended[i][j] = cost_max + 1;
-                }
-            }
+            throw std::runtime_error("lapjv: failed to solve the assignment");
         }
+        return collect_solution(cost, workspace.x.data(), workspace.y.data(),
+                                rowsol, colsol, return_cost);
+    }
 
-        for (int i = n_rows; i < cost_c_extended.size(); i++)
-        {
-            for (int j = n_cols; j < cost_c_extended[i].size(); j++)
-            {
-                cost_c_extended[i][j] = 0;
-            }
-        }
+    // Rows and columns may be left unassigned: solved natively as a rectangular problem instead of
+    // extending the matrix to (n_rows + n_cols)^2 with dummy rows and columns of cost dummy_cost.
+    // Leaving a pair unassigned costs 2 * dummy_cost, that is cost_limit when it is given
+    const float unassigned_cost =
+            limit_cost ? cost_limit : 2 * (cost.maxCoeff() + 1);
+
+    // Augmenting paths are searched from the smaller side
+    const bool transpose = n_rows > n_cols;
+    const int n_sap_rows = transpose ? n_cols : n_rows;
+    const int n_sap_cols = transpose ? n_rows : n_cols;
+    const float *cost_c = row_major_cost(cost, workspace, transpose);
+    workspace.x.resize(n_sap_rows);
+    workspace.y.resize(n_sap_cols);
+
+    // Warm start from the seeds of the caller, in the orientation of the solver: the seeded duals are those of the
+    // columns of the solver, i.e. of the rows of the cost matrix when it is transposed
+    LsapWarmStart<float> warm_start;
+    const bool seeded = duals &&
+                        duals->row_seeds.size() == static_cast<size_t>(n_rows) &&
+                        duals->row_duals.size() == static_cast<size_t>(n_rows) &&
+                        duals->col_duals.size() == static_cast<size_t>(n_cols);
+    if (seeded)
+    {
+        workspace.seeds.assign(n_sap_rows, -1);
         for (int i = 0; i < n_rows; i++)
         {
-            for (int j = 0; j < n_cols; j++)
+            const int j = duals->row_seeds[i];
+            if (j < 0 || j >= n_cols)
             {
-                cost_c_extended[i][j] = cost_c[i][j];
+                continue;
             }
-        }
 
-        cost_c.clear();
-        cost_c.assign(cost_c_extended.begin(), cost_c_extended.end());
+            if (transpose)
+                workspace.seeds[j] = i;
+            else
+                workspace.seeds[i] = j;
+        }
+        warm_start.x = workspace.seeds.data();
+        warm_start.v = transpose ? duals->row_duals.data()
+                                 : duals->col_duals.data();
     }
 
-    double **cost_ptr;
-    cost_ptr = new double *[n];
-    for (int i = 0; i < n; i++) cost_ptr[i] = new double[n];
-
-    for (int i = 0; i < n; i++)
+    if (lsap_solve<float>(n_sap_rows, n_sap_cols, cost_c, unassigned_cost,
+                          workspace.x.data(), workspace.y.data(),
+                          workspace.lsap_buffers, 0.1f,
+                          seeded ? &warm_start : nullptr) != 0)
     {
-        for (int j = 0; j < n; j++) { cost_ptr[i][j] = cost_c[i][j]; }
+        throw std::runtime_error("lapjv: failed to solve the assignment");
     }
 
-    int *x_c = new int[n];
-    int *y_c = new int[n];
-
-    int ret = lapjv_internal(n, cost_ptr, x_c, y_c);
-    if (ret != 0)
+    if (duals)
     {
-        std::cout << "Calculate Wrong!" << std::endl;
-        exit(0);
+        const std::vector<float> &u = workspace.lsap_buffers.u;
+        const std::vector<float> &v = workspace.lsap_buffers.v;
+        const std::vector<float> &row_duals = transpose ? v : u;
+        const std::vector<float> &col_duals = transpose ? u : v;
+        duals->row_duals.assign(row_duals.begin(), row_duals.begin() + n_rows);
+        duals->col_duals.assign(col_duals.begin(), col_duals.begin() + n_cols);
     }
 
-    double opt = 0.0;
+    const int_t *x_c = transpose ? workspace.y.data() : workspace.x.data();
+    const int_t *y_c = transpose ? workspace.x.data() : workspace.y.data();
+    return collect_solution(cost, x_c, y_c, rowsol, colsol, return_cost);
+}
 
-    if (n != n_rows)
+double auction(const CostMatrix &cost, std::vector<int> &rowsol,
+               std::vector<int> &colsol, LapjvWorkspace &workspace,
+               float cost_limit, float epsilon, ThreadPool *thread_pool,
+               bool return_cost)
+{
+    const int n_rows = static_cast<int>(cost.rows());
+    const int n_cols = static_cast<int>(cost.cols());
+    rowsol.assign(n_rows, -1);
+    colsol.assign(n_cols, -1);
+    if (n_rows == 0 || n_cols == 0)
     {
-        for (int i = 0; i < n; i++)
-        {
-            if (x_c[i] >= n_cols) x_c[i] = -1;
-            if (y_c[i] >= n_rows) y_c[i] = -1;
-        }
-        for (int i = 0; i < n_rows; i++) { rowsol[i] = x_c[i]; }
-        for (int i = 0; i < n_cols; i++) { colsol[i] = y_c[i]; }
+        return 0.0;
+    }
 
-        if (return_cost)
-        {
-            for (int i = 0; i < rowsol.size(); i++)
-            {
-                if (rowsol[i] != -1) { opt += cost_ptr[i][rowsol[i]]; }
-            }
-        }
+    const float unassigned_cost =
+            cost_limit < std::numeric_limits<float>::max()
+                    ? cost_limit
+                    : std::numeric_limits<float>::infinity();
+
+    const bool transpose = n_rows > n_cols;
+    const int n_sap_rows = transpose ? n_cols : n_rows;
+    const int n_sap_cols = transpose ? n_rows : n_cols;
+    const float *cost_c = row_major_cost(cost, workspace, transpose);
+    workspace.x.resize(n_sap_rows);
+    workspace.y.resize(n_sap_cols);
+    if (lsap_auction<float>(n_sap_rows, n_sap_cols, cost_c, unassigned_cost,
+                            workspace.x.data(), workspace.y.data(),
+                            workspace.auction_buffers, epsilon,
+                            thread_pool) != 0)
+    {
+        throw std::runtime_error("auction: failed to solve the assignment");
     }
-    else if (return_cost)
+
+    const int_t *x_c = transpose ? workspace.y.data() : workspace.x.data();
+    const int_t *y_c = transpose ? workspace.x.data() : workspace.y.data();
+    return collect_solution(cost, x_c, y_c, rowsol, colsol, return_cost);
+}
+
+double greedy(const CostMatrix &cost, std::vector<int> &rowsol,
+              std::vector<int> &colsol, LapjvWorkspace &workspace,
+              float cost_limit, bool return_cost)
+{
+    const int n_rows = static_cast<int>(cost.rows());
+    const int n_cols = static_cast<int>(cost.cols());
+    rowsol.assign(n_rows, -1);
+    colsol.assign(n_cols, -1);
+    if (n_rows == 0 || n_cols == 0)
     {
-        for (int i = 0; i < rowsol.size(); i++)
-        {
-            opt += cost_ptr[i][rowsol[i]];
-        }
+        return 0.0;
     }
 
-    for (int i = 0; i < n; i++) { delete[] cost_ptr[i]; }
-    delete[] cost_ptr;
-    delete[] x_c;
-    delete[] y_c;
+    // The greedy matching is symmetric, the column-major data is used in place as its transpose
+    const float *cost_c = cost.data();
+    workspace.x.resize(n_cols);
+    workspace.y.resize(n_rows);
+    lsap_greedy<float>(n_cols, n_rows, cost_c, cost_limit, workspace.x.data(),
+                       workspace.y.data(), workspace.lsap_buffers);
 
-    return opt;
+    return collect_solution(cost, workspace.y.data(), workspace.x.data(),
+                            rowsol, colsol, return_cost);
+}
+
+double lapjv(const CostMatrix &cost, std::vector<int> &rowsol,
+             std::vector<int> &colsol, bool extend_cost, float cost_limit,
+             bool return_cost)
+{
+    LapjvWorkspace workspace;
+    return lapjv(cost, rowsol, colsol, workspace, extend_cost, cost_limit,
+                 return_cost);
 }
-    
+
 }
@@ -6,14 +6,27 @@ int KalmanTracker::kf_count = 0;
 
 // initialize Kalman filter
 void KalmanTracker::init_kf(StateType stateMat)
+{
+    init_model(kf);
+
+    measurement = cv::Mat::zeros(kf.measurementMatrix.rows, 1, CV_32F);
+
+    // initialize state vector with bounding box in [cx,cy,s,r] style
+    kf.statePost.at<float>(0, 0) = stateMat.x + stateMat.width / 2;
+    kf.statePost.at<float>(1, 0) = stateMat.y + stateMat.height / 2;
+    kf.statePost.at<float>(2, 0) = stateMat.area();
+    kf.statePost.at<float>(3, 0) = stateMat.width / stateMat.height;
+}
+
+
+// constant velocity model and noise covariances, shared by all trackers
+void KalmanTracker::init_model(cv::KalmanFilter& filter)
 {
     int stateNum = 7;
     int measureNum = 4;
-    kf = cv::KalmanFilter(stateNum, measureNum, 0);
-
-    measurement = cv::Mat::zeros(measureNum, 1, CV_32F);
+    filter.init(stateNum, measureNum, 0);
 
-    kf.transitionMatrix = (cv::Mat_<float>(stateNum, stateNum) <<
+    filter.transitionMatrix = (cv::Mat_<float>(stateNum, stateNum) <<
         1, 0, 0, 0, 1, 0, 0,
         0, 1, 0, 0, 0, 1, 0,
         0, 0, 1, 0, 0, 0, 1,
@@ -22,24 +35,50 @@ void KalmanTracker::init_kf(StateType stateMat)
         0, 0, 0, 0, 0, 1, 0,
         0, 0, 0, 0, 0, 0, 1);
 
-    cv::setIdentity(kf.measurementMatrix);
-    cv::setIdentity(kf.processNoiseCov, cv::Scalar::all(1e-2));
-    cv::setIdentity(kf.measurementNoiseCov, cv::Scalar::all(1e-1));
-    cv::setIdentity(kf.errorCovPost, cv::Scalar::all(1));
+    cv::setIdentity(filter.measurementMatrix);
+    cv::setIdentity(filter.processNoiseCov, cv::Scalar::all(1e-2));
+    cv::setIdentity(filter.measurementNoiseCov, cv::Scalar::all(1e-1));
+    cv::setIdentity(filter.errorCovPost, cv::Scalar::all(1));
+}
 
-    // initialize state vector with bounding box in [cx,cy,s,r] style
-    kf.statePost.at<float>(0, 0) = stateMat.x + stateMat.width / 2;
-    kf.statePost.at<float>(1, 0) = stateMat.y + stateMat.height / 2;
-    kf.statePost.at<float>(2, 0) = stateMat.area();
-    kf.statePost.at<float>(3, 0) = stateMat.width / stateMat.height;
+
+// The noise covariances are constant, so the covariance of a tracker updated in every frame
+// converges to a fixed point and the gain to a constant. The covariance does not depend on
+// the measurements, iterate the filter with zero innovation until the gain settles.
+const cv::Mat& KalmanTracker::steady_state_gain()
+{
+    static const cv::Mat gain = [] {
+        cv::KalmanFilter filter;
+        init_model(filter);
+        cv::Mat previous = filter.gain.clone();
+        for (int i = 0; i < 1000; i++) {
+            filter.predict();
+            filter.correct(filter.measurementMatrix * filter.statePre);
+            if (cv::norm(filter.gain, previous, cv::NORM_INF) < 1e-6)
+                break;
+            filter.gain.copyTo(previous);
+        }
+        return filter.gain.clone();
+    }();
+    return gain;
 }
 
 
 // Predict the estimated bounding box.
 StateType KalmanTracker::predict()
 {
-    // predict
-    cv::Mat p = kf.predict();
+    // predict. A tracker updated in every frame of a long enough hit streak has converged,
+    // only its state is propagated and the covariance keeps its last full update
+    m_steady_state = m_steady_state_after > 0 && m_time_since_update == 0 &&
+                     m_hit_streak >= m_steady_state_after;
+    cv::Mat p;
+    if (m_steady_state) {
+        kf.statePre = kf.transitionMatrix * kf.statePost;
+        kf.statePre.copyTo(kf.statePost);
+        p = kf.statePre;
+    } else {
+        p = kf.predict();
+    }
     m_age += 1;
 
     if (m_time_since_update > 0)
@@ -68,7 +107,10 @@ void KalmanTracker::update(StateType stateMat)
     measurement.at<float>(3, 0) = stateMat.width / stateMat.height;
 
     // update
-    kf.correct(measurement);
+    if (m_steady_state)
+        kf.statePost = kf.statePre + steady_state_gain() * (measurement - kf.measurementMatrix * kf.statePre);
+    else
+        kf.correct(measurement);
 }
 
 
@@ -21,9 +21,11 @@ public:
         m_id = kf_count;
         kf_count++;
     }
-    KalmanTracker(StateType initRect)
+    // steady_state_after: hit streak after which the tracker uses the steady-state gain, 0 disables it
+    KalmanTracker(StateType initRect, int steady_state_after = 0)
     {
         init_kf(initRect);
+        m_steady_state_after = steady_state_after;
         m_time_since_update = 0;
         m_hits = 0;
         m_hit_streak = 0;
@@ -43,6 +45,9 @@ public:
     StateType get_state();
     StateType get_rect_xysr(float cx, float cy, float s, float r);
 
+    // Kalman gain the filter converges to when it is updated in every frame
+    static const cv::Mat& steady_state_gain();
+
     static int kf_count;
 
     int m_time_since_update;
@@ -53,9 +58,13 @@ public:
 
 private:
     void init_kf(StateType stateMat);
+    static void init_model(cv::KalmanFilter& filter);
 
     cv::KalmanFilter kf;
     cv::Mat measurement;
 
+    int m_steady_state_after = 0;
+    bool m_steady_state = false;
+
     std::vector<StateType> m_history;
 };
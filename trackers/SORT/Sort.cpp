@@ -2,6 +2,8 @@
 // Sort.cpp: SORT(Simple Online and Realtime Tracking) Class Implementation
 //
 #include "Sort.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 
 
@@ -25,7 +27,7 @@ std::vector<TrackingBox> Sort::update(const std::vector<TrackingBox>& detect_fra
     if (m_trackers.size() == 0) { // the first frame met
         // initialize kalman trackers using first detections.
         for (unsigned int i = 0; i < detect_frame_data.size(); i++) {
-            KalmanTracker track = KalmanTracker(detect_frame_data[i].box);
+            KalmanTracker track = KalmanTracker(detect_frame_data[i].box, m_kalman_steady_state_after);
             m_trackers.push_back(track);
         }
         return std::vector<TrackingBox>{};
@@ -56,7 +58,7 @@ std::vector<TrackingBox> Sort::update(const std::vector<TrackingBox>& detect_fra
     if (track_num == 0) {
         // No active trackers left, bootstrap from current detections
         for (unsigned int i = 0; i < detect_num; ++i) {
-            m_trackers.emplace_back(detect_frame_data[i].box);
+            m_trackers.emplace_back(detect_frame_data[i].box, m_kalman_steady_state_after);
         }
         return std::vector<TrackingBox>{};
     }
@@ -81,57 +83,61 @@ std::vector<TrackingBox> Sort::update(const std::vector<TrackingBox>& detect_fra
         return m_tracking_output;
     }
 
-    std::vector<std::vector<double>> iou_matrix;
-    iou_matrix.resize(track_num, std::vector<double>(detect_num, 0));
-
+    const auto association_start = std::chrono::steady_clock::now();
+    m_cost_matrix.resize(track_num * detect_num);
     for (unsigned int i = 0; i < track_num; i++) { // compute iou matrix as a distance matrix
         for (unsigned int j = 0; j < detect_num; j++) {
-            // use 1-iou because the hungarian algorithm computes a minimum-cost assignment.
-            iou_matrix[i][j] = 1 - get_iou(predicted_boxes[i], detect_frame_data[j].box);
+            // use 1-iou because the assignment solver computes a minimum-cost assignment.
+            m_cost_matrix[i * detect_num + j] = 1 - get_iou(predicted_boxes[i], detect_frame_data[j].box);
         }
     }
 
-    // solve the assignment problem using hungarian algorithm.
-    // the resulting assignment is [track(prediction) : detection], with len=preNum
-    std::vector<int> assignment;
-    HungarianAlgorithm HungAlgo;
-    HungAlgo.Solve(iou_matrix, assignment);
-
-    // find matches, unmatched_detections and unmatched_predictions
-    std::set<int> unmatched_detections;
-    std::set<int> unmatched_trajectories;
-    std::set<int> all_items;
-    std::set<int> matched_items;
-
-    if (detect_num > track_num) { // there are unmatched detections
-        for (unsigned int n = 0; n < detect_num; n++)
-            all_items.insert(n);
-
-        for (unsigned int i = 0; i < track_num; ++i)
-            matched_items.insert(assignment[i]);
-
-        std::set_difference(all_items.begin(), all_items.end(),
-                matched_items.begin(), matched_items.end(),
-                std::insert_iterator<std::set<int>>(unmatched_detections, unmatched_detections.begin()));
+    // solve the assignment problem, pairs with an IOU below the threshold are never matched.
+    // the resulting assignment is [track(prediction) : detection], with len=preNum, -1 for unmatched tracks
+    m_track_assignment.resize(track_num);
+    m_detect_assignment.resize(detect_num);
+    const float unassigned_cost = static_cast<float>(1 - m_iou_threshold);
+    auto elapsed_us = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+    };
+    bool greedy = m_solver == botsort::AssignmentSolver::Greedy;
+    if (m_solver == botsort::AssignmentSolver::Budgeted)
+        greedy = m_time_model.fall_back(track_num, detect_num, m_time_budget_us - elapsed_us(association_start));
+
+    int solve_status;
+    if (m_solver == botsort::AssignmentSolver::Auction)
+        solve_status = botsort::lsap_auction<float>(track_num, detect_num, m_cost_matrix.data(), unassigned_cost,
+                                                    m_track_assignment.data(), m_detect_assignment.data(),
+                                                    m_auction_buffers, m_auction_epsilon, m_thread_pool.get());
+    else if (greedy)
+        solve_status = botsort::lsap_greedy<float>(track_num, detect_num, m_cost_matrix.data(), unassigned_cost,
+                                                   m_track_assignment.data(), m_detect_assignment.data(),
+                                                   m_lsap_buffers);
+    else {
+        const auto solve_start = std::chrono::steady_clock::now();
+        solve_status = botsort::lsap_solve<float>(track_num, detect_num, m_cost_matrix.data(), unassigned_cost,
+                                                  m_track_assignment.data(), m_detect_assignment.data(),
+                                                  m_lsap_buffers);
+        m_time_model.update(track_num, detect_num, elapsed_us(solve_start));
     }
-    else if (detect_num < track_num) { // there are unmatched trajectory/predictions
-        for (unsigned int i = 0; i < track_num; ++i)
-            if (assignment[i] == -1) // unassigned label will be set as -1 in the assignment algorithm
-                unmatched_trajectories.insert(i);
+
+    // a failed solve leaves the assignment undefined, every track and detection is then unmatched
+    if (solve_status != 0) {
+        std::fill(m_track_assignment.begin(), m_track_assignment.end(), -1);
+        std::fill(m_detect_assignment.begin(), m_detect_assignment.end(), -1);
     }
 
-    // filter out matched with low IOU
+    // find matches and unmatched_detections
     std::vector<cv::Point> matched_pairs;
     for (unsigned int i = 0; i < track_num; ++i) {
-        if (assignment[i] == -1) { // pass over invalid values
-            continue;
-        }
-        if (1 - iou_matrix[i][assignment[i]] < m_iou_threshold) {
-            unmatched_trajectories.insert(i);
-            unmatched_detections.insert(assignment[i]);
-        }
-        else
-            matched_pairs.push_back(cv::Point(i, assignment[i]));
+        if (m_track_assignment[i] != -1)
+            matched_pairs.push_back(cv::Point(i, m_track_assignment[i]));
+    }
+
+    std::vector<int> unmatched_detections;
+    for (unsigned int j = 0; j < detect_num; ++j) {
+        if (m_detect_assignment[j] == -1)
+            unmatched_detections.push_back(j);
     }
 
     ///////////////////////////////////////
@@ -147,7 +153,7 @@ std::vector<TrackingBox> Sort::update(const std::vector<TrackingBox>& detect_fra
 
     // create and initialise new trackers for unmatched detections
     for (auto unmatched_det_index : unmatched_detections) {
-        KalmanTracker tracker = KalmanTracker(detect_frame_data[unmatched_det_index].box);
+        KalmanTracker tracker = KalmanTracker(detect_frame_data[unmatched_det_index].box, m_kalman_steady_state_after);
         m_trackers.push_back(tracker);
     }
 
@@ -6,7 +6,9 @@
 #include <opencv2/core/types.hpp>
 #include "opencv2/video/tracking.hpp"
 #include "opencv2/highgui/highgui.hpp"
-#include "Hungarian.hpp"
+#include "auction.h"
+#include "lsap.h"
+#include "ThreadPool.h"
 #include "KalmanTracker.hpp"
 #include <set>
 #include <iomanip> // to format image names using setw() and setfill()
@@ -38,6 +40,24 @@ public:
         m_frame_count = 0;
     }
 
+    // solver selects the assignment backend. The auction solver computes its bids on
+    // hardware_concurrency - 1 worker threads, auction_epsilon is its optimality tolerance.
+    // The budgeted solver matches greedily when the exact solve would exceed time_budget_us.
+    // Trackers whose hit streak reaches kalman_steady_state_after use the steady-state Kalman gain (0 disables it)
+    Sort(int max_age, int min_hits, double iou_threshold,
+         botsort::AssignmentSolver solver, float auction_epsilon = 1e-4f,
+         float time_budget_us = 1000.0f, int kalman_steady_state_after = 0)
+        : Sort(max_age, min_hits, iou_threshold)
+    {
+        m_solver = solver;
+        m_auction_epsilon = auction_epsilon;
+        m_time_budget_us = time_budget_us;
+        m_kalman_steady_state_after = kalman_steady_state_after;
+        unsigned int num_threads = std::thread::hardware_concurrency();
+        if (m_solver == botsort::AssignmentSolver::Auction && num_threads > 1)
+            m_thread_pool = std::make_unique<botsort::ThreadPool>(num_threads - 1);
+    }
+
     ~Sort() {}
 
     std::vector<TrackingBox> update(const std::vector<TrackingBox>& detect_frame_data);
@@ -48,4 +68,16 @@ private:
     int m_frame_count;
     std::vector<KalmanTracker> m_trackers;
     std::vector<TrackingBox> m_tracking_output;
+    // association buffers, reused across frames
+    std::vector<float> m_cost_matrix;
+    std::vector<int> m_track_assignment;
+    std::vector<int> m_detect_assignment;
+    botsort::LsapBuffers<float> m_lsap_buffers;
+    botsort::AuctionBuffers<float> m_auction_buffers;
+    botsort::AssignmentSolver m_solver = botsort::AssignmentSolver::LAPJV;
+    float m_auction_epsilon = 1e-4f;
+    float m_time_budget_us = 1000.0f;
+    int m_kalman_steady_state_after = 0;
+    botsort::SolveTimeModel m_time_model;
+    std::unique_ptr<botsort::ThreadPool> m_thread_pool;
 };
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace botsort
+{
+
+/**
+ * @brief Fixed-size pool of worker threads executing submitted tasks in FIFO order
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Construct a new Thread Pool object
+     *
+     * @param num_threads Number of worker threads
+     */
+    explicit ThreadPool(size_t num_threads)
+    {
+        _workers.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; i++)
+        {
+            _workers.emplace_back([this]() { _worker_loop(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _condition.notify_all();
+        for (std::thread &worker: _workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Submit a task to the pool
+     *
+     * @param task Callable without arguments
+     * @return std::future Future holding the result of the task
+     */
+    template<typename F>
+    auto submit(F &&task) -> std::future<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        auto packaged_task = std::make_shared<std::packaged_task<Result()>>(
+                std::forward<F>(task));
+        std::future<Result> result = packaged_task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.emplace([packaged_task]() { (*packaged_task)(); });
+        }
+        _condition.notify_one();
+        return result;
+    }
+
+    /**
+     * @brief Get the number of worker threads
+     *
+     * @return size_t Number of worker threads
+     */
+    size_t size() const
+    {
+        return _workers.size();
+    }
+
+private:
+    void _worker_loop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this]() {
+                    return _stopping || !_tasks.empty();
+                });
+                if (_stopping && _tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop();
+            }
+            task();
+        }
+    }
+
+private:
+    std::vector<std::thread> _workers;
+    std::queue<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopping = false;
+};
+
+}// namespace botsort
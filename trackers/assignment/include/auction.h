@@ -0,0 +1,57 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "lapjv.h"
+
+namespace botsort
+{
+
+class ThreadPool;
+
+/**
+ * @brief Scratch buffers of lsap_auction. They only grow, so a solver reusing the same
+ *  buffers does not allocate once it has seen its largest problem.
+ */
+template<typename cost_t>
+struct AuctionBuffers
+{
+    // Per object: price, owner, and the best bid of the current round
+    std::vector<cost_t> prices, best_bids;
+    std::vector<int_t> owners, best_bidders;
+
+    // Per person: assigned object, and the bid of the current round
+    std::vector<int_t> assignments, bid_objects;
+    std::vector<cost_t> bid_prices;
+
+    std::vector<int_t> bidders, next_bidders, bid_targets;
+};
+
+/**
+ * @brief Solve a rectangular linear assignment problem with the epsilon-scaling auction algorithm.
+ *  Same problem as lsap_internal: each row is either assigned to a column, or left unassigned for unassigned_cost.
+ *  It is made square without building a larger matrix: the objects are the columns plus a private dummy object per
+ *  row (leaving the row unassigned), and virtual persons with a zero cost for every object take the objects left
+ *  over by the rows. Each round, all the unassigned persons bid at once (Jacobi auction), so the bids are computed
+ *  in parallel on the thread pool when there are enough of them.
+ *  The assignment is within (n_rows + n_cols) * epsilon of the optimal total cost.
+ *
+ * @param n_rows Number of rows of the cost matrix
+ * @param n_cols Number of columns of the cost matrix
+ * @param cost Cost matrix, stored row-major in a flat buffer of n_rows * n_cols elements
+ * @param unassigned_cost Cost of leaving a row unassigned. If infinite, every row is assigned, which requires n_rows <= n_cols
+ * @param x Output column assigned to each row, -1 if unassigned (n_rows elements)
+ * @param y Output row assigned to each column, -1 if unassigned (n_cols elements)
+ * @param buffers Scratch buffers
+ * @param epsilon Final epsilon of the scaling, i.e. the optimality tolerance per assigned pair
+ * @param thread_pool (Optional) Thread pool on which to compute the bids
+ * @return int_t 0 on success, -1 if the problem is infeasible
+ */
+template<typename cost_t>
+int_t lsap_auction(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                   const cost_t unassigned_cost, int_t *x, int_t *y,
+                   AuctionBuffers<cost_t> &buffers, const cost_t epsilon,
+                   ThreadPool *thread_pool = nullptr);
+
+}// namespace botsort
@@ -0,0 +1,52 @@
+// Adapted from: https://github.com/ifzhang/ByteTrack/blob/main/deploy/ncnn/cpp/include/lapjv.h
+// The solver works on a flat row-major cost buffer, is templated on the cost type
+// and takes its scratch memory from a reusable LapjvBuffers object.
+
+#pragma once
+
+#include <vector>
+
+namespace botsort
+{
+
+typedef signed int int_t;
+typedef unsigned int uint_t;
+typedef char boolean;
+
+/**
+ * @brief Scratch buffers of lapjv_internal. They only grow, so a solver reusing the same
+ *  buffers does not allocate once it has seen its largest problem.
+ */
+template<typename cost_t>
+struct LapjvBuffers
+{
+    std::vector<int_t> free_rows, cols, pred;
+    std::vector<cost_t> v, d;
+    std::vector<boolean> unique;
+
+    void reserve(uint_t n)
+    {
+        if (v.size() < n)
+        {
+            free_rows.resize(n), cols.resize(n), pred.resize(n);
+            v.resize(n), d.resize(n);
+            unique.resize(n);
+        }
+    }
+};
+
+/**
+ * @brief Solve a dense square linear assignment problem with the Jonker-Volgenant algorithm
+ *
+ * @param n Number of rows and columns of the cost matrix
+ * @param cost Cost matrix, stored row-major in a flat buffer of n * n elements
+ * @param x Output column assigned to each row (n elements)
+ * @param y Output row assigned to each column (n elements)
+ * @param buffers Scratch buffers
+ * @return int_t 0 on success, a negative value if the solver failed
+ */
+template<typename cost_t>
+int_t lapjv_internal(const uint_t n, const cost_t *cost, int_t *x, int_t *y,
+                     LapjvBuffers<cost_t> &buffers);
+
+}// namespace botsort
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "lapjv.h"
+
+namespace botsort
+{
+
+/**
+ * @brief Linear assignment solvers
+ *
+ * LAPJV: exact shortest augmenting path solvers (lapjv_internal, lsap_internal, lsap_sparse_internal)
+ * Auction: epsilon-scaling auction with parallel bidding (lsap_auction), for very large problems
+ * Greedy: best-first matching of the cheapest pairs (lsap_greedy), not optimal but fast and with a bounded cost
+ * Budgeted: LAPJV, falling back to Greedy when the exact solve is predicted to exceed a time budget
+ */
+enum class AssignmentSolver
+{
+    LAPJV = 0,
+    Auction,
+    Greedy,
+    Budgeted
+};
+
+/**
+ * @brief Scratch buffers of lsap_internal. They only grow, so a solver reusing the same
+ *  buffers does not allocate once it has seen its largest problem.
+ */
+template<typename cost_t>
+struct LsapBuffers
+{
+    std::vector<cost_t> u, v, shortest_path_costs;
+    std::vector<int_t> path, remaining;
+    std::vector<boolean> scanned_rows, scanned_cols;
+
+    // Sparse solver: feasible edges in CSR format, and the state of the shortest path search
+    std::vector<int_t> row_offsets, col_indices;
+    std::vector<cost_t> values;
+    std::vector<std::pair<cost_t, int_t>> heap;
+    std::vector<int_t> visited_rows, touched_cols;
+
+    // Rows left to augment
+    std::vector<int_t> free_rows;
+
+    // Greedy solver: feasible edges, as (cost, row-major index) pairs
+    std::vector<std::pair<cost_t, size_t>> edges;
+
+    void reserve(uint_t n_rows, uint_t n_cols)
+    {
+        if (u.size() < n_rows)
+        {
+            u.resize(n_rows);
+            scanned_rows.resize(n_rows);
+        }
+        if (v.size() < n_cols)
+        {
+            v.resize(n_cols), shortest_path_costs.resize(n_cols);
+            path.resize(n_cols), remaining.resize(n_cols);
+            scanned_cols.resize(n_cols);
+        }
+    }
+};
+
+/**
+ * @brief Starting point of lsap_internal, usually the solution of a similar previous problem.
+ *  Every seeded pair whose column is the cheapest of its row at the seeded column duals is kept, with tight duals,
+ *  and only the other rows are augmented. The dual of a seeded column is first raised, within its zero bound, when
+ *  that is enough to make it the cheapest of its row again. Seeds still inconsistent with the duals are dropped (and
+ *  their column dual reset), so any seed gives the optimal assignment, a good one just gives it faster.
+ *
+ * const int_t *x: Column seeded for each row, -1 if none (n_rows elements)
+ * const cost_t *v: Seeded dual variable of each column, as left in LsapBuffers::v by a previous solve, only used
+ *  for the seeded columns (n_cols elements)
+ */
+template<typename cost_t>
+struct LsapWarmStart
+{
+    const int_t *x = nullptr;
+    const cost_t *v = nullptr;
+};
+
+/**
+ * @brief Solve a rectangular linear assignment problem with shortest augmenting paths (Jonker-Volgenant / Crouse).
+ *  Each row is either assigned to a column, or left unassigned for unassigned_cost. Leaving a row unassigned
+ *  is modelled by a private dummy column per row, which is only ever reached from its own row, so the dummies
+ *  are handled implicitly as extra sinks of the shortest path search and the matrix is never extended.
+ *  With a finite unassigned_cost, a pair (i, j) is only assigned when it is worth it, i.e. the result is the
+ *  same as solving the problem extended with dummy rows and columns of cost unassigned_cost / 2.
+ *  The dual variables of the solution are left in buffers.u (rows) and buffers.v (columns).
+ *
+ * @param n_rows Number of rows of the cost matrix
+ * @param n_cols Number of columns of the cost matrix
+ * @param cost Cost matrix, stored row-major in a flat buffer of n_rows * n_cols elements
+ * @param unassigned_cost Cost of leaving a row unassigned. If infinite, every row is assigned, which requires n_rows <= n_cols
+ * @param x Output column assigned to each row, -1 if unassigned (n_rows elements)
+ * @param y Output row assigned to each column, -1 if unassigned (n_cols elements)
+ * @param buffers Scratch buffers
+ * @param warm_start (Optional) Seeded assignment and column prices
+ * @return int_t 0 on success, -1 if the problem is infeasible
+ */
+template<typename cost_t>
+int_t lsap_internal(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                    const cost_t unassigned_cost, int_t *x, int_t *y,
+                    LsapBuffers<cost_t> &buffers,
+                    const LsapWarmStart<cost_t> *warm_start = nullptr);
+
+/**
+ * @brief Sparse version of lsap_internal, in the spirit of LAPMOD: the cost matrix is given as the list of feasible
+ *  edges of each row (CSR format), and the shortest path search is a Dijkstra over those edges with a binary heap.
+ *  Missing edges are infeasible. Each augmentation only touches the rows and columns it reaches.
+ *
+ * @param n_rows Number of rows
+ * @param n_cols Number of columns
+ * @param row_offsets Edges of row i are [row_offsets[i], row_offsets[i + 1]) (n_rows + 1 elements)
+ * @param col_indices Column of each edge
+ * @param values Cost of each edge
+ * @param unassigned_cost Cost of leaving a row unassigned. If infinite, every row is assigned
+ * @param x Output column assigned to each row, -1 if unassigned (n_rows elements)
+ * @param y Output row assigned to each column, -1 if unassigned (n_cols elements)
+ * @param buffers Scratch buffers
+ * @param warm_start (Optional) Seeded assignment and column prices
+ * @return int_t 0 on success, -1 if the problem is infeasible
+ */
+template<typename cost_t>
+int_t lsap_sparse_internal(const uint_t n_rows, const uint_t n_cols,
+                           const int_t *row_offsets, const int_t *col_indices,
+                           const cost_t *values, const cost_t unassigned_cost,
+                           int_t *x, int_t *y, LsapBuffers<cost_t> &buffers,
+                           const LsapWarmStart<cost_t> *warm_start = nullptr);
+
+/**
+ * @brief Solve a rectangular linear assignment problem given as a dense cost matrix, see lsap_internal.
+ *  Edges that can never be assigned (infinite, or above unassigned_cost) are counted first: when the fraction of
+ *  feasible edges is at most max_sparse_density, the feasible edges are gathered in CSR format and the problem is
+ *  solved with lsap_sparse_internal, otherwise with the dense solver.
+ *
+ * @param n_rows Number of rows of the cost matrix
+ * @param n_cols Number of columns of the cost matrix
+ * @param cost Cost matrix, stored row-major in a flat buffer of n_rows * n_cols elements
+ * @param unassigned_cost Cost of leaving a row unassigned. If infinite, every row is assigned
+ * @param x Output column assigned to each row, -1 if unassigned (n_rows elements)
+ * @param y Output row assigned to each column, -1 if unassigned (n_cols elements)
+ * @param buffers Scratch buffers
+ * @param max_sparse_density Maximum fraction of feasible edges for which the sparse solver is used
+ * @param warm_start (Optional) Seeded assignment and column prices
+ * @return int_t 0 on success, -1 if the problem is infeasible
+ */
+template<typename cost_t>
+int_t lsap_solve(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                 const cost_t unassigned_cost, int_t *x, int_t *y,
+                 LsapBuffers<cost_t> &buffers,
+                 const float max_sparse_density = 0.1f,
+                 const LsapWarmStart<cost_t> *warm_start = nullptr);
+
+/**
+ * @brief Greedy best-first matching: the feasible pairs (finite, and not above unassigned_cost) are taken by
+ *  increasing cost, ties by row then column, skipping the pairs whose row or column is already matched.
+ *  Stops as soon as every row or every column is matched. The pairs are kept in a heap, so only the popped pairs
+ *  are ordered: O(E + k log E) for E feasible pairs and k popped ones.
+ *  The matching is not optimal, but never assigns an infeasible pair.
+ *
+ * @param n_rows Number of rows of the cost matrix
+ * @param n_cols Number of columns of the cost matrix
+ * @param cost Cost matrix, stored row-major in a flat buffer of n_rows * n_cols elements
+ * @param unassigned_cost Pairs above this cost are never matched
+ * @param x Output column assigned to each row, -1 if unassigned (n_rows elements)
+ * @param y Output row assigned to each column, -1 if unassigned (n_cols elements)
+ * @param buffers Scratch buffers
+ * @return int_t 0, the greedy matching always exists
+ */
+template<typename cost_t>
+int_t lsap_greedy(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                  const cost_t unassigned_cost, int_t *x, int_t *y,
+                  LsapBuffers<cost_t> &buffers);
+
+/**
+ * @brief Predicts the duration of the exact solvers from the previous solves, to decide when a time-budgeted
+ *  assignment falls back to lsap_greedy. The duration is modelled as proportional to
+ *  n_rows * n_cols * min(n_rows, n_cols), the bound of the shortest augmenting path solvers, with a factor
+ *  smoothed over the measured solves. The model is only measured by exact solves, so after remeasure_interval
+ *  consecutive fallbacks an exact solve is allowed anyway, and its measurement replaces the smoothed factor:
+ *  a single slow solve can't make the fallback permanent.
+ */
+struct SolveTimeModel
+{
+    // Smoothed duration per unit of work, in microseconds. 0 until the first measurement
+    double us_per_unit = 0.0;
+
+    static double work(uint_t n_rows, uint_t n_cols)
+    {
+        return static_cast<double>(n_rows) * n_cols * std::min(n_rows, n_cols);
+    }
+
+    double predict_us(uint_t n_rows, uint_t n_cols) const
+    {
+        return us_per_unit * work(n_rows, n_cols);
+    }
+
+    /**
+     * @brief Whether the problem should be matched greedily, i.e. its exact solve is predicted to exceed
+     *  budget_us and the model was re-measured recently enough. Counts the consecutive fallbacks.
+     */
+    bool fall_back(uint_t n_rows, uint_t n_cols, double budget_us)
+    {
+        if (predict_us(n_rows, n_cols) <= budget_us)
+        {
+            consecutive_fallbacks = 0;
+            return false;
+        }
+        if (++consecutive_fallbacks > remeasure_interval)
+        {
+            consecutive_fallbacks = 0;
+            remeasuring = true;
+            return false;
+        }
+        return true;
+    }
+
+    void update(uint_t n_rows, uint_t n_cols, double elapsed_us)
+    {
+        const double units = work(n_rows, n_cols);
+        if (units <= 0)
+        {
+            return;
+        }
+
+        const double measured = elapsed_us / units;
+        us_per_unit = us_per_unit > 0 && !remeasuring
+                              ? (1 - smoothing) * us_per_unit + smoothing * measured
+                              : measured;
+        remeasuring = false;
+    }
+
+private:
+    static constexpr double smoothing = 0.2;
+    static constexpr int remeasure_interval = 16;
+    int consecutive_fallbacks = 0;
+    bool remeasuring = false;
+};
+
+}// namespace botsort
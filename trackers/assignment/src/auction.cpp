@@ -0,0 +1,305 @@
+#include "auction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+#include "ThreadPool.h"
+
+namespace botsort
+{
+
+namespace
+{
+// Epsilon is divided by this factor after each scaling phase
+constexpr int scaling_factor = 5;
+
+// Minimum number of bids per thread before the bids of a round are computed in parallel
+constexpr size_t min_bids_per_thread = 64;
+}// namespace
+
+template<typename cost_t>
+int_t lsap_auction(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                   const cost_t unassigned_cost, int_t *x, int_t *y,
+                   AuctionBuffers<cost_t> &buffers, const cost_t epsilon,
+                   ThreadPool *thread_pool)
+{
+    constexpr cost_t infinity = std::numeric_limits<cost_t>::infinity();
+    const bool can_leave_unassigned = unassigned_cost < infinity;
+    if (n_rows > n_cols && !can_leave_unassigned)
+    {
+        return -1;
+    }
+
+    std::fill_n(x, n_rows, -1);
+    std::fill_n(y, n_cols, -1);
+    if (n_rows == 0)
+    {
+        return 0;
+    }
+
+    // Objects: columns, then the dummy object of each row. Persons: rows, then virtual persons
+    const uint_t n_objects = n_cols + (can_leave_unassigned ? n_rows : 0);
+    const uint_t n_persons = n_objects;
+
+    // Range of the finite costs, including the dummies and the virtual persons, sets the first epsilon
+    cost_t min_cost = 0, max_cost = 0;
+    for (size_t k = 0; k < static_cast<size_t>(n_rows) * n_cols; k++)
+    {
+        if (cost[k] < infinity)
+        {
+            min_cost = std::min(min_cost, cost[k]);
+            max_cost = std::max(max_cost, cost[k]);
+        }
+    }
+    if (can_leave_unassigned)
+    {
+        min_cost = std::min(min_cost, unassigned_cost);
+        max_cost = std::max(max_cost, unassigned_cost);
+    }
+    const cost_t cost_range = std::max(max_cost - min_cost, cost_t(1e-6));
+    const cost_t final_epsilon = std::max(epsilon, cost_range * cost_t(1e-6));
+    const cost_t start_epsilon = std::max(final_epsilon, cost_range / 4);
+
+    // Rows can always be left unassigned when unassigned_cost is finite. Otherwise the problem may be infeasible:
+    // prices of a feasible problem stay bounded, beyond this bound some row cannot be assigned. Every bid also adds
+    // up to the phase epsilon, which dominates the cost range when the costs are (nearly) equal
+    const cost_t price_limit =
+            can_leave_unassigned
+                    ? infinity
+                    : cost_t(2) * n_persons *
+                              (std::max(std::abs(min_cost), std::abs(max_cost)) +
+                               cost_range + start_epsilon);
+
+    buffers.prices.assign(n_objects, cost_t(0));
+    buffers.best_bids.assign(n_objects, -infinity);
+    buffers.owners.resize(n_objects);
+    buffers.best_bidders.resize(n_objects);
+    buffers.assignments.resize(n_persons);
+    buffers.bid_objects.resize(n_persons);
+    buffers.bid_prices.resize(n_persons);
+    cost_t *prices = buffers.prices.data();
+    cost_t *best_bids = buffers.best_bids.data();
+    int_t *owners = buffers.owners.data();
+    int_t *best_bidders = buffers.best_bidders.data();
+    int_t *assignments = buffers.assignments.data();
+    int_t *bid_objects = buffers.bid_objects.data();
+    cost_t *bid_prices = buffers.bid_prices.data();
+    std::vector<int_t> &bidders = buffers.bidders;
+    std::vector<int_t> &next_bidders = buffers.next_bidders;
+    std::vector<int_t> &bid_targets = buffers.bid_targets;
+
+    // Bid of a row: the cheapest object, at the price that makes it as expensive as the second cheapest plus epsilon
+    auto row_bid = [&](int_t person, cost_t eps) {
+        const cost_t *cost_i = cost + static_cast<size_t>(person) * n_cols;
+        cost_t w1 = infinity, w2 = infinity;
+        int_t best_object = -1;
+        for (uint_t j = 0; j < n_cols; j++)
+        {
+            const cost_t w = cost_i[j] + prices[j];
+            if (w < w1)
+            {
+                w2 = w1;
+                w1 = w;
+                best_object = static_cast<int_t>(j);
+            }
+            else if (w < w2)
+            {
+                w2 = w;
+            }
+        }
+        if (can_leave_unassigned)
+        {
+            const int_t dummy = static_cast<int_t>(n_cols) + person;
+            const cost_t w = unassigned_cost + prices[dummy];
+            if (w < w1)
+            {
+                w2 = w1;
+                w1 = w;
+                best_object = dummy;
+            }
+            else if (w < w2)
+            {
+                w2 = w;
+            }
+        }
+
+        if (w1 == infinity)
+        {
+            bid_objects[person] = -1;
+            return;
+        }
+
+        // With a single reachable object, any increment keeps epsilon-complementary slackness
+        if (w2 == infinity)
+        {
+            w2 = w1;
+        }
+        bid_objects[person] = best_object;
+        bid_prices[person] = std::max(prices[best_object] + (w2 - w1) + eps,
+                                      std::nextafter(prices[best_object], infinity));
+    };
+
+    cost_t eps = start_epsilon;
+    while (true)
+    {
+        // Each phase starts from scratch with the prices of the previous one
+        std::fill_n(owners, n_objects, -1);
+        std::fill_n(assignments, n_persons, -1);
+        bidders.resize(n_persons);
+        for (uint_t p = 0; p < n_persons; p++)
+        {
+            bidders[p] = static_cast<int_t>(p);
+        }
+
+        while (!bidders.empty())
+        {
+            // Bids of the rows, in parallel when there are enough of them
+            const size_t n_row_bidders = static_cast<size_t>(
+                    std::lower_bound(bidders.begin(), bidders.end(),
+                                     static_cast<int_t>(n_rows)) -
+                    bidders.begin());
+            const size_t n_chunks =
+                    thread_pool ? std::clamp<size_t>(
+                                          n_row_bidders / min_bids_per_thread,
+                                          1, thread_pool->size() + 1)
+                                : 1;
+            auto bid_chunk = [&](size_t chunk) {
+                const size_t begin = chunk * n_row_bidders / n_chunks;
+                const size_t end = (chunk + 1) * n_row_bidders / n_chunks;
+                for (size_t b = begin; b < end; b++)
+                {
+                    row_bid(bidders[b], eps);
+                }
+            };
+            if (n_chunks > 1)
+            {
+                std::vector<std::future<void>> pending;
+                for (size_t chunk = 1; chunk < n_chunks; chunk++)
+                {
+                    pending.push_back(thread_pool->submit(
+                            [&, chunk]() { bid_chunk(chunk); }));
+                }
+                bid_chunk(0);
+                for (std::future<void> &result: pending)
+                {
+                    result.get();
+                }
+            }
+            else
+            {
+                bid_chunk(0);
+            }
+
+            // Virtual persons are all alike: the k of them bid on the k cheapest objects, at the (k + 1)-th
+            // cheapest price plus epsilon
+            const size_t n_virtual_bidders = bidders.size() - n_row_bidders;
+            if (n_virtual_bidders > 0)
+            {
+                bid_targets.resize(n_objects);
+                for (uint_t k = 0; k < n_objects; k++)
+                {
+                    bid_targets[k] = static_cast<int_t>(k);
+                }
+                auto cheaper = [prices](int_t a, int_t b) {
+                    return prices[a] < prices[b] ||
+                           (prices[a] == prices[b] && a < b);
+                };
+                std::nth_element(bid_targets.begin(),
+                                 bid_targets.begin() + n_virtual_bidders,
+                                 bid_targets.end(), cheaper);
+                std::sort(bid_targets.begin(),
+                          bid_targets.begin() + n_virtual_bidders, cheaper);
+
+                const cost_t virtual_price =
+                        prices[bid_targets[n_virtual_bidders]] + eps;
+                for (size_t v = 0; v < n_virtual_bidders; v++)
+                {
+                    const int_t person = bidders[n_row_bidders + v];
+                    bid_objects[person] = bid_targets[v];
+                    bid_prices[person] = std::max(
+                            virtual_price,
+                            std::nextafter(prices[bid_targets[v]], infinity));
+                }
+            }
+
+            // Each object goes to its highest bid, ties to the first bidder
+            bid_targets.clear();
+            for (int_t person: bidders)
+            {
+                const int_t object = bid_objects[person];
+                if (object < 0 || bid_prices[person] > price_limit)
+                {
+                    return -1;
+                }
+
+                if (best_bids[object] == -infinity)
+                {
+                    bid_targets.push_back(object);
+                }
+                if (bid_prices[person] > best_bids[object])
+                {
+                    best_bids[object] = bid_prices[person];
+                    best_bidders[object] = person;
+                }
+            }
+
+            next_bidders.clear();
+            for (int_t person: bidders)
+            {
+                if (best_bidders[bid_objects[person]] != person)
+                {
+                    next_bidders.push_back(person);
+                }
+            }
+            for (int_t object: bid_targets)
+            {
+                const int_t winner = best_bidders[object];
+                if (owners[object] >= 0)
+                {
+                    assignments[owners[object]] = -1;
+                    next_bidders.push_back(owners[object]);
+                }
+                owners[object] = winner;
+                assignments[winner] = object;
+                prices[object] = best_bids[object];
+                best_bids[object] = -infinity;
+            }
+
+            // Rows first: they are the ones bidding in parallel
+            std::sort(next_bidders.begin(), next_bidders.end());
+            std::swap(bidders, next_bidders);
+        }
+
+        if (eps <= final_epsilon)
+        {
+            break;
+        }
+        eps = std::max(final_epsilon, eps / scaling_factor);
+    }
+
+    for (uint_t i = 0; i < n_rows; i++)
+    {
+        if (assignments[i] < static_cast<int_t>(n_cols))
+        {
+            x[i] = assignments[i];
+            y[assignments[i]] = static_cast<int_t>(i);
+        }
+    }
+    return 0;
+}
+
+template int_t lsap_auction<float>(const uint_t n_rows, const uint_t n_cols,
+                                   const float *cost,
+                                   const float unassigned_cost, int_t *x,
+                                   int_t *y, AuctionBuffers<float> &buffers,
+                                   const float epsilon,
+                                   ThreadPool *thread_pool);
+template int_t lsap_auction<double>(const uint_t n_rows, const uint_t n_cols,
+                                    const double *cost,
+                                    const double unassigned_cost, int_t *x,
+                                    int_t *y, AuctionBuffers<double> &buffers,
+                                    const double epsilon,
+                                    ThreadPool *thread_pool);
+
+}// namespace botsort
@@ -0,0 +1,587 @@
+#include "lsap.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace botsort
+{
+
+namespace
+{
+/**
+ * @brief Initial state of the shortest augmenting path solvers: an empty assignment with zero duals, or the seeded
+ *  pairs of the warm start that are consistent with the seeded prices. for_each_edge(i, f) calls f(j, cost) for the
+ *  edges of row i. Fills free_rows with the rows left to augment.
+ */
+template<typename cost_t, typename ForEachEdge>
+void initialize_assignment(const uint_t n_rows, const uint_t n_cols,
+                           const cost_t unassigned_cost,
+                           const LsapWarmStart<cost_t> *warm_start,
+                           ForEachEdge for_each_edge, int_t *x, int_t *y,
+                           cost_t *u, cost_t *v, std::vector<int_t> &free_rows)
+{
+    constexpr cost_t infinity = std::numeric_limits<cost_t>::infinity();
+    std::fill_n(u, n_rows, cost_t(0));
+    std::fill_n(v, n_cols, cost_t(0));
+    std::fill_n(x, n_rows, -1);
+    std::fill_n(y, n_cols, -1);
+
+    if (warm_start)
+    {
+        // Free columns must keep a zero price, only the seeded columns get theirs (prices are never positive)
+        for (uint_t i = 0; i < n_rows; i++)
+        {
+            const int_t j = warm_start->x[i];
+            if (j >= 0 && j < static_cast<int_t>(n_cols) && y[j] == -1)
+            {
+                x[i] = j;
+                y[j] = static_cast<int_t>(i);
+                v[j] = std::min(warm_start->v[j], cost_t(0));
+            }
+        }
+
+        // Reduced cost of the seeded pair of row i, and the lowest reduced cost of the row
+        auto seeded_and_lowest = [&](uint_t i) {
+            cost_t seeded = infinity, lowest = infinity;
+            for_each_edge(i, [&](int_t j, cost_t c) {
+                const cost_t r = c - v[j];
+                lowest = std::min(lowest, r);
+                if (j == x[i])
+                {
+                    seeded = r;
+                }
+            });
+            return std::make_pair(seeded, lowest);
+        };
+
+        // The costs changed since the prices were computed: the dual of a seeded column is first raised, within
+        // the zero bound, so that the column is the cheapest of its row again
+        for (uint_t i = 0; i < n_rows; i++)
+        {
+            if (x[i] < 0)
+            {
+                continue;
+            }
+
+            const auto [seeded, lowest] = seeded_and_lowest(i);
+            if (seeded < infinity && seeded > lowest)
+            {
+                v[x[i]] = std::min(cost_t(0), v[x[i]] + seeded - lowest);
+            }
+        }
+
+        // A seeded pair is kept when its column is the cheapest of the row, and cheaper than leaving the row
+        // unassigned. Dropping a pair frees its column and resets its price, which may invalidate other pairs,
+        // so the check is repeated until nothing is dropped
+        bool dropped = true;
+        while (dropped)
+        {
+            dropped = false;
+            for (uint_t i = 0; i < n_rows; i++)
+            {
+                if (x[i] < 0)
+                {
+                    continue;
+                }
+
+                const auto [seeded, lowest] = seeded_and_lowest(i);
+                if (seeded == infinity || seeded > lowest ||
+                    seeded > unassigned_cost)
+                {
+                    v[x[i]] = 0;
+                    y[x[i]] = -1;
+                    x[i] = -1;
+                    u[i] = 0;
+                    dropped = true;
+                }
+                else
+                {
+                    u[i] = seeded;
+                }
+            }
+        }
+    }
+
+    free_rows.clear();
+    for (uint_t i = 0; i < n_rows; i++)
+    {
+        if (x[i] < 0)
+        {
+            free_rows.push_back(static_cast<int_t>(i));
+        }
+    }
+}
+}// namespace
+
+template<typename cost_t>
+int_t lsap_internal(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                    const cost_t unassigned_cost, int_t *x, int_t *y,
+                    LsapBuffers<cost_t> &buffers,
+                    const LsapWarmStart<cost_t> *warm_start)
+{
+    constexpr cost_t infinity = std::numeric_limits<cost_t>::infinity();
+    const bool can_leave_unassigned = unassigned_cost < infinity;
+    if (n_rows > n_cols && !can_leave_unassigned)
+    {
+        return -1;
+    }
+
+    buffers.reserve(n_rows, n_cols);
+    cost_t *u = buffers.u.data();
+    cost_t *v = buffers.v.data();
+    cost_t *shortest_path_costs = buffers.shortest_path_costs.data();
+    int_t *path = buffers.path.data();
+    int_t *remaining = buffers.remaining.data();
+    boolean *scanned_rows = buffers.scanned_rows.data();
+    boolean *scanned_cols = buffers.scanned_cols.data();
+
+    auto for_each_edge = [cost, n_cols](uint_t i, auto &&visit) {
+        const cost_t *cost_i = cost + static_cast<size_t>(i) * n_cols;
+        for (uint_t j = 0; j < n_cols; j++)
+        {
+            visit(static_cast<int_t>(j), cost_i[j]);
+        }
+    };
+    initialize_assignment(n_rows, n_cols, unassigned_cost, warm_start,
+                          for_each_edge, x, y, u, v, buffers.free_rows);
+
+    for (const int_t cur_row: buffers.free_rows)
+    {
+        // Dijkstra over the reduced costs, from cur_row to the closest free column, or to the dummy
+        // column of one of the scanned rows. Dummy columns are always free: a row assigned to its dummy
+        // can only be reached through that dummy, so it is never scanned again.
+        uint_t num_remaining = n_cols;
+        for (uint_t it = 0; it < n_cols; it++)
+        {
+            remaining[it] = n_cols - it - 1;
+        }
+        std::fill_n(scanned_rows, n_rows, false);
+        std::fill_n(scanned_cols, n_cols, false);
+        std::fill_n(shortest_path_costs, n_cols, infinity);
+
+        cost_t min_val = 0;
+        int_t i = cur_row;
+        int_t sink = -1, unassigned_row = -1;
+        cost_t unassigned_path_cost = infinity;
+        bool leave_unassigned = false;
+        while (sink == -1 && !leave_unassigned)
+        {
+            scanned_rows[i] = true;
+            const cost_t *cost_i = cost + static_cast<size_t>(i) * n_cols;
+
+            if (can_leave_unassigned &&
+                min_val + unassigned_cost - u[i] < unassigned_path_cost)
+            {
+                unassigned_path_cost = min_val + unassigned_cost - u[i];
+                unassigned_row = i;
+            }
+
+            int_t index = -1;
+            cost_t lowest = infinity;
+            for (uint_t it = 0; it < num_remaining; it++)
+            {
+                const int_t j = remaining[it];
+                const cost_t r = min_val + cost_i[j] - u[i] - v[j];
+                if (r < shortest_path_costs[j])
+                {
+                    path[j] = i;
+                    shortest_path_costs[j] = r;
+                }
+
+                // Prefer free columns on ties, they end the search
+                if (shortest_path_costs[j] < lowest ||
+                    (shortest_path_costs[j] == lowest && y[j] == -1))
+                {
+                    lowest = shortest_path_costs[j];
+                    index = static_cast<int_t>(it);
+                }
+            }
+
+            // Leaving a row unassigned only wins when it is strictly cheaper than the closest column
+            if (unassigned_row != -1 && unassigned_path_cost < lowest)
+            {
+                min_val = unassigned_path_cost;
+                leave_unassigned = true;
+                break;
+            }
+
+            // No column is reachable at a finite cost
+            if (lowest == infinity)
+            {
+                return -1;
+            }
+
+            min_val = lowest;
+            const int_t j = remaining[index];
+            if (y[j] == -1)
+            {
+                sink = j;
+            }
+            else
+            {
+                i = y[j];
+            }
+
+            scanned_cols[j] = true;
+            remaining[index] = remaining[--num_remaining];
+        }
+
+        // Update the dual variables
+        u[cur_row] += min_val;
+        for (uint_t r = 0; r < n_rows; r++)
+        {
+            if (scanned_rows[r] && static_cast<int_t>(r) != cur_row)
+            {
+                u[r] += min_val - shortest_path_costs[x[r]];
+            }
+        }
+        for (uint_t c = 0; c < n_cols; c++)
+        {
+            if (scanned_cols[c])
+            {
+                v[c] -= min_val - shortest_path_costs[c];
+            }
+        }
+
+        // Augment along the path. If it ends on a dummy column, its row gives up its column
+        int_t j = sink;
+        if (leave_unassigned)
+        {
+            i = unassigned_row;
+            j = x[i];
+            x[i] = -1;
+            if (i == static_cast<int_t>(cur_row))
+            {
+                continue;
+            }
+        }
+        while (true)
+        {
+            i = path[j];
+            y[j] = i;
+            std::swap(j, x[i]);
+            if (i == static_cast<int_t>(cur_row))
+            {
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+template<typename cost_t>
+int_t lsap_sparse_internal(const uint_t n_rows, const uint_t n_cols,
+                           const int_t *row_offsets, const int_t *col_indices,
+                           const cost_t *values, const cost_t unassigned_cost,
+                           int_t *x, int_t *y, LsapBuffers<cost_t> &buffers,
+                           const LsapWarmStart<cost_t> *warm_start)
+{
+    constexpr cost_t infinity = std::numeric_limits<cost_t>::infinity();
+    const bool can_leave_unassigned = unassigned_cost < infinity;
+    if (n_rows > n_cols && !can_leave_unassigned)
+    {
+        return -1;
+    }
+
+    buffers.reserve(n_rows, n_cols);
+    cost_t *u = buffers.u.data();
+    cost_t *v = buffers.v.data();
+    cost_t *shortest_path_costs = buffers.shortest_path_costs.data();
+    int_t *path = buffers.path.data();
+    boolean *scanned_rows = buffers.scanned_rows.data();
+    boolean *scanned_cols = buffers.scanned_cols.data();
+    std::vector<std::pair<cost_t, int_t>> &heap = buffers.heap;
+    std::vector<int_t> &visited_rows = buffers.visited_rows;
+    std::vector<int_t> &touched_cols = buffers.touched_cols;
+
+    auto for_each_edge = [row_offsets, col_indices, values](uint_t i,
+                                                            auto &&visit) {
+        for (int_t e = row_offsets[i]; e < row_offsets[i + 1]; e++)
+        {
+            visit(col_indices[e], values[e]);
+        }
+    };
+    initialize_assignment(n_rows, n_cols, unassigned_cost, warm_start,
+                          for_each_edge, x, y, u, v, buffers.free_rows);
+
+    // The search state is reset once here, then only for the rows and columns each augmentation touched
+    std::fill_n(scanned_rows, n_rows, false);
+    std::fill_n(scanned_cols, n_cols, false);
+    std::fill_n(shortest_path_costs, n_cols, infinity);
+
+    // Min-heap of (shortest path cost, column), entries made stale by a later decrease are skipped when popped
+    auto heap_greater = [](const std::pair<cost_t, int_t> &a,
+                           const std::pair<cost_t, int_t> &b) {
+        return a > b;
+    };
+
+    int_t ret = 0;
+    for (size_t f = 0; f < buffers.free_rows.size() && ret == 0; f++)
+    {
+        const int_t cur_row = buffers.free_rows[f];
+        heap.clear();
+        visited_rows.clear();
+        touched_cols.clear();
+
+        cost_t min_val = 0;
+        int_t i = cur_row;
+        int_t sink = -1, unassigned_row = -1;
+        cost_t unassigned_path_cost = infinity;
+        bool leave_unassigned = false;
+        while (sink == -1 && !leave_unassigned)
+        {
+            scanned_rows[i] = true;
+            visited_rows.push_back(i);
+
+            if (can_leave_unassigned &&
+                min_val + unassigned_cost - u[i] < unassigned_path_cost)
+            {
+                unassigned_path_cost = min_val + unassigned_cost - u[i];
+                unassigned_row = i;
+            }
+
+            for (int_t e = row_offsets[i]; e < row_offsets[i + 1]; e++)
+            {
+                const int_t j = col_indices[e];
+                if (scanned_cols[j])
+                {
+                    continue;
+                }
+
+                const cost_t r = min_val + values[e] - u[i] - v[j];
+                if (r < shortest_path_costs[j])
+                {
+                    if (shortest_path_costs[j] == infinity)
+                    {
+                        touched_cols.push_back(j);
+                    }
+                    path[j] = i;
+                    shortest_path_costs[j] = r;
+                    heap.emplace_back(r, j);
+                    std::push_heap(heap.begin(), heap.end(), heap_greater);
+                }
+            }
+
+            while (!heap.empty() &&
+                   (scanned_cols[heap.front().second] ||
+                    heap.front().first !=
+                            shortest_path_costs[heap.front().second]))
+            {
+                std::pop_heap(heap.begin(), heap.end(), heap_greater);
+                heap.pop_back();
+            }
+            const cost_t lowest = heap.empty() ? infinity : heap.front().first;
+
+            // Leaving a row unassigned only wins when it is strictly cheaper than the closest column
+            if (unassigned_row != -1 && unassigned_path_cost < lowest)
+            {
+                min_val = unassigned_path_cost;
+                leave_unassigned = true;
+                break;
+            }
+
+            if (heap.empty())
+            {
+                ret = -1;
+                break;
+            }
+
+            min_val = lowest;
+            const int_t j = heap.front().second;
+            std::pop_heap(heap.begin(), heap.end(), heap_greater);
+            heap.pop_back();
+
+            scanned_cols[j] = true;
+            if (y[j] == -1)
+            {
+                sink = j;
+            }
+            else
+            {
+                i = y[j];
+            }
+        }
+
+        if (ret == 0)
+        {
+            // Update the dual variables
+            u[cur_row] += min_val;
+            for (int_t r: visited_rows)
+            {
+                if (r != static_cast<int_t>(cur_row))
+                {
+                    u[r] += min_val - shortest_path_costs[x[r]];
+                }
+            }
+            for (int_t c: touched_cols)
+            {
+                if (scanned_cols[c])
+                {
+                    v[c] -= min_val - shortest_path_costs[c];
+                }
+            }
+
+            // Augment along the path. If it ends on a dummy column, its row gives up its column
+            int_t j = sink;
+            bool augment = true;
+            if (leave_unassigned)
+            {
+                i = unassigned_row;
+                j = x[i];
+                x[i] = -1;
+                augment = i != static_cast<int_t>(cur_row);
+            }
+            while (augment)
+            {
+                i = path[j];
+                y[j] = i;
+                std::swap(j, x[i]);
+                augment = i != static_cast<int_t>(cur_row);
+            }
+        }
+
+        for (int_t r: visited_rows)
+        {
+            scanned_rows[r] = false;
+        }
+        for (int_t c: touched_cols)
+        {
+            scanned_cols[c] = false;
+            shortest_path_costs[c] = infinity;
+        }
+    }
+
+    return ret;
+}
+
+template<typename cost_t>
+int_t lsap_solve(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                 const cost_t unassigned_cost, int_t *x, int_t *y,
+                 LsapBuffers<cost_t> &buffers, const float max_sparse_density,
+                 const LsapWarmStart<cost_t> *warm_start)
+{
+    // Pairs costing more than leaving the row unassigned are never part of an optimal assignment
+    const size_t n_entries = static_cast<size_t>(n_rows) * n_cols;
+    auto feasible = [unassigned_cost](cost_t c) {
+        return c <= unassigned_cost &&
+               c < std::numeric_limits<cost_t>::infinity();
+    };
+    const size_t n_edges = static_cast<size_t>(
+            std::count_if(cost, cost + n_entries, feasible));
+    if (n_edges > max_sparse_density * n_entries)
+    {
+        return lsap_internal(n_rows, n_cols, cost, unassigned_cost, x, y,
+                             buffers, warm_start);
+    }
+
+    buffers.row_offsets.resize(n_rows + 1);
+    buffers.col_indices.resize(n_edges);
+    buffers.values.resize(n_edges);
+    int_t n_stored = 0;
+    for (uint_t i = 0; i < n_rows; i++)
+    {
+        buffers.row_offsets[i] = n_stored;
+        const cost_t *cost_i = cost + static_cast<size_t>(i) * n_cols;
+        for (uint_t j = 0; j < n_cols; j++)
+        {
+            if (feasible(cost_i[j]))
+            {
+                buffers.col_indices[n_stored] = j;
+                buffers.values[n_stored] = cost_i[j];
+                n_stored++;
+            }
+        }
+    }
+    buffers.row_offsets[n_rows] = n_stored;
+
+    return lsap_sparse_internal(n_rows, n_cols, buffers.row_offsets.data(),
+                                buffers.col_indices.data(),
+                                buffers.values.data(), unassigned_cost, x, y,
+                                buffers, warm_start);
+}
+
+template<typename cost_t>
+int_t lsap_greedy(const uint_t n_rows, const uint_t n_cols, const cost_t *cost,
+                  const cost_t unassigned_cost, int_t *x, int_t *y,
+                  LsapBuffers<cost_t> &buffers)
+{
+    constexpr cost_t infinity = std::numeric_limits<cost_t>::infinity();
+    std::fill_n(x, n_rows, -1);
+    std::fill_n(y, n_cols, -1);
+
+    std::vector<std::pair<cost_t, size_t>> &edges = buffers.edges;
+    edges.clear();
+    const size_t n_elements = static_cast<size_t>(n_rows) * n_cols;
+    for (size_t k = 0; k < n_elements; k++)
+    {
+        if (cost[k] <= unassigned_cost && cost[k] < infinity)
+        {
+            edges.emplace_back(cost[k], k);
+        }
+    }
+
+    // Min-heap on (cost, index): ties go to the first row, then the first column
+    const std::greater<std::pair<cost_t, size_t>> cheaper_last;
+    std::make_heap(edges.begin(), edges.end(), cheaper_last);
+
+    const uint_t max_matches = std::min(n_rows, n_cols);
+    uint_t n_matches = 0;
+    auto heap_end = edges.end();
+    while (heap_end != edges.begin() && n_matches < max_matches)
+    {
+        std::pop_heap(edges.begin(), heap_end, cheaper_last);
+        --heap_end;
+        const int_t i = static_cast<int_t>(heap_end->second / n_cols);
+        const int_t j = static_cast<int_t>(heap_end->second % n_cols);
+        if (x[i] < 0 && y[j] < 0)
+        {
+            x[i] = j;
+            y[j] = i;
+            n_matches++;
+        }
+    }
+    return 0;
+}
+
+template int_t lsap_internal<float>(const uint_t n_rows, const uint_t n_cols,
+                                    const float *cost,
+                                    const float unassigned_cost, int_t *x,
+                                    int_t *y, LsapBuffers<float> &buffers,
+                                    const LsapWarmStart<float> *warm_start);
+template int_t lsap_internal<double>(const uint_t n_rows, const uint_t n_cols,
+                                     const double *cost,
+                                     const double unassigned_cost, int_t *x,
+                                     int_t *y, LsapBuffers<double> &buffers,
+                                     const LsapWarmStart<double> *warm_start);
+template int_t lsap_sparse_internal<float>(
+        const uint_t n_rows, const uint_t n_cols, const int_t *row_offsets,
+        const int_t *col_indices, const float *values,
+        const float unassigned_cost, int_t *x, int_t *y,
+        LsapBuffers<float> &buffers, const LsapWarmStart<float> *warm_start);
+template int_t lsap_sparse_internal<double>(
+        const uint_t n_rows, const uint_t n_cols, const int_t *row_offsets,
+        const int_t *col_indices, const double *values,
+        const double unassigned_cost, int_t *x, int_t *y,
+        LsapBuffers<double> &buffers, const LsapWarmStart<double> *warm_start);
+template int_t lsap_solve<float>(const uint_t n_rows, const uint_t n_cols,
+                                 const float *cost, const float unassigned_cost,
+                                 int_t *x, int_t *y, LsapBuffers<float> &buffers,
+                                 const float max_sparse_density,
+                                 const LsapWarmStart<float> *warm_start);
+template int_t lsap_solve<double>(const uint_t n_rows, const uint_t n_cols,
+                                  const double *cost,
+                                  const double unassigned_cost, int_t *x,
+                                  int_t *y, LsapBuffers<double> &buffers,
+                                  const float max_sparse_density,
+                                  const LsapWarmStart<double> *warm_start);
+template int_t lsap_greedy<float>(const uint_t n_rows, const uint_t n_cols,
+                                  const float *cost, const float unassigned_cost,
+                                  int_t *x, int_t *y, LsapBuffers<float> &buffers);
+template int_t lsap_greedy<double>(const uint_t n_rows, const uint_t n_cols,
+                                   const double *cost,
+                                   const double unassigned_cost, int_t *x,
+                                   int_t *y, LsapBuffers<double> &buffers);
+
+}// namespace botsort